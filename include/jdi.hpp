@@ -6,9 +6,21 @@
 #ifndef _JDI_HPP_
 #define _JDI_HPP_
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <filesystem>
+#include <functional>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include <SDL.h>
@@ -20,8 +32,10 @@ namespace jdi {
 
   // JDI Class Predeclarations
   class Color;
+  class DrawList;
   class Engine;
   class Grid;
+  class RenderThread;
   class Sprite;
   class Text;
   class Widget;
@@ -61,6 +75,22 @@ namespace jdi {
     JDI_SEW  = 14,
     JDI_NSEW = 15,
   };
+
+  // Classes of SDL event, for Widget::setEventMask().  Masks are ORs of these.
+  enum event_mask_type {
+    JDI_EVENTS_NONE     = 0,
+    JDI_EVENTS_KEY      = 1 << 0,  // Key down and up
+    JDI_EVENTS_TEXT     = 1 << 1,  // Text input and editing
+    JDI_EVENTS_MOUSE    = 1 << 2,  // Motion, buttons and wheel
+    JDI_EVENTS_TOUCH    = 1 << 3,  // Fingers and gestures
+    JDI_EVENTS_JOYSTICK = 1 << 4,  // Joysticks and game controllers
+    JDI_EVENTS_DROP     = 1 << 5,  // Drag and drop
+    JDI_EVENTS_WINDOW   = 1 << 6,
+    JDI_EVENTS_OTHER    = 1 << 7,  // Everything else, user events included
+    JDI_EVENTS_ALL      = 0xff,
+  };
+
+  const int JDI_EVENT_CLASS_COUNT = 8;
   
   ////
   // A deleter which performs free-equivalents for SDL objects
@@ -141,8 +171,14 @@ namespace jdi {
 
 
 #include "jdi_color.hpp"
+#include "jdi_queue.hpp"
+#include "jdi_jobs.hpp"
+#include "jdi_input.hpp"
+#include "jdi_hitindex.hpp"
+#include "jdi_bus.hpp"
 #include "jdi_engine.hpp"
 #include "jdi_sprite.hpp"
+#include "jdi_render.hpp"
 #include "jdi_widget.hpp"
 
 #include "jdi_grid.hpp"
@@ -0,0 +1,289 @@
+// File: jdi_bus.hpp
+// ----
+// Typed messages between widgets, delivered only to their subscribers.
+
+namespace jdi {
+
+  typedef enum {
+    JDI_DELIVER_SAME_FRAME = 0,  // After this pass's updates, before it draws
+    JDI_DELIVER_NEXT_FRAME,      // At the start of the next frame's pass
+  } delivery_type;
+
+  ////
+  // A publish/subscribe channel per message type.  Messages are queued and
+  // handed to that type's subscribers at set points of the engine's pass,
+  // never to the rest of the tree.  Payloads come from a pool per type and
+  // go back to it after delivery, so once the pool has grown to the busiest
+  // pass, publishing allocates nothing.  Order is kept within a type, not
+  // across types.
+  //
+  // A subscription owned by a widget ends with the widget and is skipped
+  // while the widget is disabled.  Subscribing or unsubscribing from a
+  // handler is fine; new subscribers start with the next message.  Engine
+  // thread only.
+  ////
+  class EventBus {
+  public:
+    typedef Uint64 subscription_type;  // 0 is never a subscription
+
+  private:
+    class channel_base_type {
+    public:
+      virtual ~channel_base_type() = default;
+
+      // Deliver what is queued for the phase.  True if anything was.
+      virtual bool deliver(delivery_type phase) = 0;
+      virtual bool hasQueued(delivery_type when) const = 0;
+      virtual bool unsubscribe(subscription_type subscription) = 0;
+      virtual void unsubscribe(const Widget* owner) = 0;
+    };
+
+    template <typename T>
+    class channel_type : public channel_base_type {
+    public:
+      typedef std::function<void(const T&)> handler_type;
+
+    private:
+      struct subscriber_type {
+        subscription_type      id;       // 0 once unsubscribed
+        widget_ptr::weak_type  owner;
+        bool                   isOwned;  // Ends with the owner
+        handler_type           handler;
+      };
+
+      typedef std::unique_ptr<T> payload_ptr;
+
+      std::vector<subscriber_type> _subscribers;
+      std::vector<subscriber_type> _joining;     // Subscribed during delivery
+      std::vector<payload_ptr>     _pool;        // Free payloads
+      std::vector<payload_ptr>     _queues[2];   // By delivery_type
+      std::vector<payload_ptr>     _delivering;
+      bool                         _isDelivering;
+      bool                         _hasDead;     // Subscribers to sweep
+
+      void deliverQueue(std::vector<payload_ptr>& queue);
+      void sweep();
+
+    public:
+      channel_type();
+
+      void add(subscriber_type&& subscriber);
+      T&   prepare(delivery_type when);
+
+      virtual bool deliver(delivery_type phase);
+      virtual bool hasQueued(delivery_type when) const;
+      virtual bool unsubscribe(subscription_type subscription);
+      virtual void unsubscribe(const Widget* owner);
+    };
+
+    typedef std::unique_ptr<channel_base_type> channel_ptr;
+
+    std::vector<channel_ptr> _channels;  // By type index
+    subscription_type        _nextSubscription;
+
+    static std::atomic<size_t> _typeCount;
+
+    static bool isEnabled(const widget_ptr& owner);  // Widget is incomplete here
+
+    template <typename T> static size_t getTypeIndex();
+    template <typename T> channel_type<T>& getChannel();
+
+  public:
+    EventBus();
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+
+    // Owner may be nullptr for a subscription that lasts until unsubscribed
+    template <typename T>
+    subscription_type subscribe(widget_ptr owner,
+                                typename channel_type<T>::handler_type handler);
+    void unsubscribe(subscription_type subscription);
+    void unsubscribe(widget_ptr owner);  // Everything it subscribed to
+
+    // Queue a message and hand back its pooled payload to fill in.  It
+    // still holds whatever the last message of its type left there, so set
+    // every field.
+    template <typename T>
+    T&   prepare(delivery_type when=JDI_DELIVER_SAME_FRAME);
+
+    // Queue a copy of the message, assigned into a pooled payload
+    template <typename T>
+    void publish(const T& message, delivery_type when=JDI_DELIVER_SAME_FRAME);
+
+    // For the engine.  The next-frame phase delivers everything queued
+    // before it; the same-frame phase repeats while handlers queue more,
+    // within reason, and leaves the rest for the next pass.
+    void deliver(delivery_type phase);
+    bool hasQueued(delivery_type when) const;
+  }; // end class EventBus
+
+
+  ////
+  // Inline
+  ////
+  template <typename T>
+  inline EventBus::channel_type<T>::channel_type() :
+    _isDelivering(false),
+    _hasDead(false)
+  {}
+
+  template <typename T>
+  inline void EventBus::channel_type<T>::add(subscriber_type&& subscriber) {
+    // Growing the list mid-delivery would move the handler being called
+    if(_isDelivering) _joining.push_back(std::move(subscriber));
+    else              _subscribers.push_back(std::move(subscriber));
+  }
+
+  template <typename T>
+  inline T& EventBus::channel_type<T>::prepare(delivery_type when) {
+    payload_ptr payload;
+    if(_pool.empty()) {
+      payload.reset(new T());
+    } else {
+      payload = std::move(_pool.back());
+      _pool.pop_back();
+    }
+
+    T& reply = *payload;
+    _queues[when].push_back(std::move(payload));
+    return(reply);
+  }
+
+  template <typename T>
+  inline void EventBus::channel_type<T>::deliverQueue(std::vector<payload_ptr>& queue) {
+    _isDelivering = true;
+    _delivering.swap(queue);  // Anything published from here on waits its turn
+
+    try {
+      // Late subscribers are in _joining, so the list holds still
+      for(auto& payload : _delivering) {
+        for(auto& subscriber : _subscribers) {
+          if(subscriber.id == 0) continue;
+          if(subscriber.isOwned) {
+            widget_ptr owner = subscriber.owner.lock();
+            if(!owner) {
+              subscriber.id = 0;
+              _hasDead = true;
+              continue;
+            }
+            if(!isEnabled(owner)) continue;
+          }
+          subscriber.handler(*payload);
+        }
+      }
+    }
+    catch(...) {
+      for(auto& payload : _delivering) _pool.push_back(std::move(payload));
+      _delivering.clear();
+      _isDelivering = false;
+      sweep();
+      throw;
+    }
+
+    for(auto& payload : _delivering) _pool.push_back(std::move(payload));
+    _delivering.clear();
+    _isDelivering = false;
+    sweep();
+  }
+
+  template <typename T>
+  inline void EventBus::channel_type<T>::sweep() {
+    if(_hasDead) {
+      _subscribers.erase(std::remove_if(_subscribers.begin(), _subscribers.end(),
+                                        [](const subscriber_type& subscriber) {
+                                          return(subscriber.id == 0);
+                                        }),
+                         _subscribers.end());
+      _hasDead = false;
+    }
+    for(auto& subscriber : _joining) {
+      if(subscriber.id != 0) _subscribers.push_back(std::move(subscriber));
+    }
+    _joining.clear();
+  }
+
+  template <typename T>
+  inline bool EventBus::channel_type<T>::deliver(delivery_type phase) {
+    if(_isDelivering) return(false);  // Not from inside a handler
+
+    bool isDelivered = false;
+    if(phase == JDI_DELIVER_NEXT_FRAME && !_queues[JDI_DELIVER_NEXT_FRAME].empty()) {
+      deliverQueue(_queues[JDI_DELIVER_NEXT_FRAME]);
+      isDelivered = true;
+    }
+    if(!_queues[JDI_DELIVER_SAME_FRAME].empty()) {
+      deliverQueue(_queues[JDI_DELIVER_SAME_FRAME]);
+      isDelivered = true;
+    }
+    return(isDelivered);
+  }
+
+  template <typename T>
+  inline bool EventBus::channel_type<T>::hasQueued(delivery_type when) const {
+    return(!_queues[when].empty());
+  }
+
+  template <typename T>
+  inline bool EventBus::channel_type<T>::unsubscribe(subscription_type subscription) {
+    for(auto* subscribers : {&_subscribers, &_joining}) {
+      for(auto& subscriber : *subscribers) {
+        if(subscriber.id != subscription) continue;
+        subscriber.id = 0;  // Its handler may be running; sweep it later
+        _hasDead = true;
+        if(!_isDelivering) sweep();
+        return(true);
+      }
+    }
+    return(false);
+  }
+
+  template <typename T>
+  inline void EventBus::channel_type<T>::unsubscribe(const Widget* owner) {
+    for(auto* subscribers : {&_subscribers, &_joining}) {
+      for(auto& subscriber : *subscribers) {
+        if(subscriber.isOwned && subscriber.owner.lock().get() == owner) {
+          subscriber.id = 0;
+          _hasDead = true;
+        }
+      }
+    }
+    if(!_isDelivering) sweep();
+  }
+
+  template <typename T>
+  inline size_t EventBus::getTypeIndex() {
+    static const size_t index = _typeCount++;
+
+    return(index);
+  }
+
+  template <typename T>
+  inline EventBus::channel_type<T>& EventBus::getChannel() {
+    size_t index = getTypeIndex<T>();
+    if(index >= _channels.size()) _channels.resize(index + 1);
+    if(!_channels[index]) _channels[index].reset(new channel_type<T>());
+
+    return(static_cast<channel_type<T>&>(*_channels[index]));
+  }
+
+  template <typename T>
+  inline EventBus::subscription_type
+  EventBus::subscribe(widget_ptr owner,
+                      typename channel_type<T>::handler_type handler) {
+    subscription_type subscription = _nextSubscription++;
+    getChannel<T>().add({subscription, owner, owner != nullptr, std::move(handler)});
+
+    return(subscription);
+  }
+
+  template <typename T>
+  inline T& EventBus::prepare(delivery_type when) {
+    return(getChannel<T>().prepare(when));
+  }
+
+  template <typename T>
+  inline void EventBus::publish(const T& message, delivery_type when) {
+    getChannel<T>().prepare(when) = message;
+  }
+
+} // end namespace jdi
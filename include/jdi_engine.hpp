@@ -8,20 +8,126 @@ namespace jdi {
   ////
   typedef enum {
     JDI_ANIMATE = 1,
+    JDI_WAKE    = 2,  // Requests were posted from another thread
   } jdi_event_type;
+
+  ////
+  // The optional pieces of SDL the engine manages.  Video and events are
+  // always up while an engine exists.
+  ////
+  typedef enum {
+    JDI_SUBSYSTEM_VIDEO = 0,
+    JDI_SUBSYSTEM_CONTROLLER,
+    JDI_SUBSYSTEM_IMAGE,
+    JDI_SUBSYSTEM_TTF,
+    JDI_SUBSYSTEM_AUDIO,
+    JDI_SUBSYSTEM_COUNT,
+  } subsystem_type;
+
+  typedef enum {
+    JDI_SUBSYSTEM_OFF  = 0,  // Never initialized; users of it fail
+    JDI_SUBSYSTEM_ON   = 1,  // Initialized when the engine is built (default)
+    JDI_SUBSYSTEM_LAZY = 2,  // Initialized on first use; see requireSubsystem()
+  } subsystem_mode_type;
+
+  ////
+  // How to bring an engine up.  Hand one to Engine::create(), or to
+  // Engine::getEngine() before the shared engine exists.  SDL subsystems are
+  // process-wide, so with several engines alive a subsystem is allowed if any
+  // of them allows it, and the image/audio parameters of the first one win.
+  //
+  // Everything starts with the engine by default.  LAZY trims startup, but
+  // code calling SDL_image, SDL_ttf or SDL_mixer directly must then call
+  // Engine::requireSubsystem() first.
+  ////
+  class EngineConfig {
+  public:
+    subsystem_mode_type controller;  // First use:  enableJoysticks(true)
+    subsystem_mode_type image;       // First use:  Sprite::createFromImage()
+    subsystem_mode_type ttf;         // First use:  Engine::loadFont()
+    subsystem_mode_type audio;       // First use:  Engine::loadChunk()/loadMusic()
+
+    int    imageFlags;      // IMG_INIT_*
+    int    mixerFlags;      // MIX_INIT_*
+    int    audioFrequency;  // Passed to Mix_OpenAudio
+    Uint16 audioFormat;
+    int    audioChannels;
+    int    audioChunkSize;
+
+    size_t jobThreads;      // Workers for runJob(); 0 for one fewer than the cores
+    bool   pipelined;       // Record with Widget::onRecord, render on a thread of its own
+    bool   headless;        // No windows and no SDL events; see Engine
+
+    // Renderer for new windows.  The driver is an SDL name ("opengl",
+    // "opengles2", "software", ...), empty for SDL's first choice, or "auto"
+    // to benchmark every driver once per set of flags and remember the
+    // winner under getPrefPath().  Flags are SDL_RENDERER_*.
+    std::string rendererDriver;
+    Uint32      rendererFlags;
+
+    EngineConfig();
+
+    subsystem_mode_type getMode(subsystem_type subsystem) const;
+  }; // end class EngineConfig
   
   
   ////
   // The engine.  Its job is to build and tear-down SDL itself, to handle the
-  // eventloop, and to associate a root widget with each window.  There's only
-  // at most one at a time, so even if you attempt to make more than one, you
-  // will always get the same one.  Mostly you should build one at the start of
-  // your program and let it clean up SDL at the end.
+  // eventloop, and to associate a root widget with each window.  Mostly you
+  // should get the shared one with getEngine() at the start of your program
+  // and let it clean up SDL at the end.  Independent engines from create()
+  // each own their windows, timing and event type; SDL itself goes away with
+  // the last engine.  Widgets find their engine through their window.
+  //
+  // SDL has a single event queue per process.  An engine which pulls an
+  // event for a window another engine owns hands it to that engine, which
+  // handles it on its own thread at its next pass.  The engines share one
+  // SDL event filter, which drops classes of event no widget wants.  SDL
+  // empties its queue whenever a filter is set, so building the first engine
+  // and destroying the last drop anything still queued; a filter the program
+  // sets after the first engine is left in place.  On several platforms
+  // SDL's video and event functions only work on the main thread, so run
+  // every engine that has windows there.  Engines on other threads should be
+  // headless (EngineConfig::headless):  they never open windows, bring up
+  // video or touch SDL's event queue, and their loop sleeps until something
+  // is posted or a deadline comes, running posted calls, job continuations,
+  // updates and the event bus until requestExit().  Ask one to exit from
+  // another thread through post().  A subsystem stays allowed only while an
+  // engine allowing it is alive.
   ////
   class Engine {
   private:
+    struct animation_datum_type {
+      widget_ptr::weak_type  widget;
+      Uint32                 ticksPerFrame;  // 0 to follow the engine frame rate
+    };
+
+    typedef std::vector<animation_datum_type> animation_seq_type;
+
+    // Written by the render thread in pipelined mode, read by the engine
+    struct present_state_type {
+      std::atomic<bool>    isInFlight{false};  // A recorded frame is not presented yet
+      std::atomic<Uint64>  presentHRC{0};
+      std::atomic<Uint64>  intraUpdateHRC{0};
+    };
+
+    typedef std::shared_ptr<present_state_type> present_state_ptr;
+    typedef std::vector<sprite_ptr::weak_type> sprite_seq_type;
+    typedef std::vector<widget_ptr::weak_type> widget_seq_type;
+
+    // An input event waiting for the frame which shows its effect
+    struct input_mark_type {
+      Uint64 dispatchHRC;
+      Uint32 ageTicks;     // Since SDL stamped it, at dispatch
+    };
+
+    typedef std::vector<input_mark_type> input_mark_seq_type;
+    typedef std::vector<Uint32> latency_seq_type;
+    
     struct window_datum_type {
       window_ptr             window;
+      Uint32                 windowID;
+      bool                   isRemoved;  // Unindexed, awaiting reapWindows()
       renderer_ptr           renderer;
       widget_ptr             root;
       widget_ptr::weak_type  focus;
@@ -33,20 +139,90 @@ namespace jdi {
       Uint64                 penultimateUpdateHRC;  // High-resolution counters
       Uint64                 ultimateUpdateHRC;
       Uint64                 intraUpdateHRC;
+      animation_seq_type     animations;            // Widgets demanding frames
+      Uint32                 animTicksPerFrame;     // Fastest demand, 0 if idle
+      Uint64                 nextFrameHRC;          // Animation deadline, 0 if unscheduled
+      int                    refreshRate;           // Of the window's display, 0 if unknown
+      Uint64                 refreshHRC;            // One refresh period, 0 if unknown
+      Uint64                 refreshNominalHRC;     // From the display's whole-Hz rate
+      Uint64                 lastPresentHRC;        // When the last present finished
+      Uint64                 missedFrames;
+      Uint64                 lateHRC;               // Last frame start past its deadline
+      Uint64                 presentHRC;            // Last time spent in SDL_RenderPresent
+      present_state_ptr      present;               // Pipelined mode only
+      std::shared_ptr<RenderThread> renderThread;   // Pipelined mode only; owns renderer
+      bool                   isDynamicRes;          // Scale down when over budget
+      float                  resScale;              // 1 at full resolution
+      float                  resFloor;
+      float                  drawAvgHRC;            // Smoothed draw time, less present
+      int                    resCooldown;           // Frames before the next change
+      texture_ptr            resTarget;             // Offscreen target when scaled
+      std::string            rendererDriver;        // Requested; empty for SDL's choice
+      Uint32                 rendererFlags;
+      sprite_seq_type        staleSprites;          // Lost their texture in a device reset
+      Uint64                 resetHRC;              // Last render reset, 0 once recovered
+      Uint64                 recoveryHRC;           // How long the last recovery took
+      input_mark_seq_type    pendingInputs;         // Dispatched since the last draw
+      latency_seq_type       latencyUSec;           // Ring of input-to-present samples
+      size_t                 latencyNext;
+      HitIndex               hitIndex;              // Rebuilt after layout
+      widget_seq_type        hovered;               // Under the mouse, topmost first
+      widget_seq_type        listeners[JDI_EVENT_CLASS_COUNT];  // Post-order, by class
+      widget_seq_type        shortcuts;             // Shortcut listeners, post-order
+      widget_seq_type        simulators;            // Want onUpdate, pre-order
+      bool                   isListenersStale;      // Tree or masks changed
+      Uint32                 eventMask;             // Union over the tree
     };
     
-    typedef std::vector<window_datum_type> window_data_type;
+    // A list keeps each datum at a stable address for as long as it lives, so
+    // pointers handed out by getDataBy*() survive removal of other windows.
+    typedef std::list<window_datum_type> window_data_type;
+    typedef std::unordered_map<Uint32, window_data_type::iterator> window_id_index_type;
+    typedef std::unordered_map<SDL_Window*, window_data_type::iterator> window_ptr_index_type;
+    typedef std::vector<window_datum_type*> window_queue_type;
     typedef std::vector<joystick_ptr> joystick_seq_type;
 
-    window_data_type _windowData;
+    window_data_type      _windowData;
+    window_id_index_type  _windowByID;
+    window_ptr_index_type _windowByPtr;
+    bool                  _isDispatching;  // Defer window reaping while true
     joystick_seq_type _joystickData;
     bool              _joysticksEnabled;
+    bool              _liveResizeEnabled;
+
+    // Joystick button edges seen in events, applied at the next snapshot
+    struct joystick_edge_type {
+      SDL_JoystickID id;
+      Uint8          button;
+      bool           isDown;
+    };
+
+    InputState                      _input;       // Published for this pass
+    InputState                      _inputNext;   // Gathering edges for the next
+    std::vector<joystick_edge_type> _joystickEdges;
+    bool              _isInLiveResize;  // Reentrancy guard for the watch
+
+    Uint32            _ticksPerFrame;
+    Uint64            _missedFrames;
+    window_queue_type _drawQueue;  // Reused by drawDueWindows()
+
+    bool         _isLateLatched;
+    Uint64       _latchMarginHRC;   // Left between drawing and the present deadline
 
-    Uint32       _ticksPerFrame;
-    SDL_TimerID  _animateTimer;
+    Uint32       _ticksPerUpdate;   // Fixed simulation step, 0 if disabled
+    Uint64       _nextUpdateHRC;    // Next step deadline, 0 if unscheduled
+    Uint64       _droppedUpdates;
+    float        _updateAlpha;
+
+    Uint32       _maxEventsPerFrame;      // 0 for no cap
+    Uint32       _maxEventTicksPerFrame;  // 0 for no time budget
 
     std::filesystem::path _basePath;
     std::filesystem::path _prefPath;
+    std::string           _rendererDriver;   // Default for new windows
+    Uint32                _rendererFlags;
+    std::unordered_map<Uint32, std::string> _autoDrivers;  // Benchmark winners by flags
+    Uint64                _benchmarkCount;
     
     void addJoystick(Uint32 deviceIndex);
     void removeJoystick(Uint32 instanceID);
@@ -59,8 +235,39 @@ namespace jdi {
 
     window_datum_type* getDataByWidget(widget_ptr widget);
     const window_datum_type* getDataByWidget(widget_ptr widget) const;
+
+    void reapWindows();
+
+    // Widgets changing their tree, event mask, shortcut or simulation role
+    // let us know through here
+    friend class Widget;
+    void invalidateListeners(Uint32 windowID);
+    void invalidateHitIndex(Uint32 windowID);
+    void updateListeners(window_datum_type* dataPtr);
+    void refreshListeners();  // Every stale window, then the event filter
+    void updateEventFilter();
+    static int SDLCALL filterEvent(void* userdata, SDL_Event* event);
+
+    // Stamp the owning window ID (and this engine) on every widget in the tree
+    void bindWidgets(widget_ptr root, Uint32 windowID);
     
     void updateRenderer(window_datum_type* dataPtr);
+    void updateOutputSize(window_datum_type* dataPtr);
+    void releaseRenderer(window_datum_type* dataPtr);
+    void handleRenderReset(bool isDeviceLost);
+    void markInput(window_datum_type* dataPtr, const SDL_Event& event);
+    void recordLatency(window_datum_type* dataPtr, const input_mark_seq_type& inputs,
+                       Uint64 doneHRC);
+    Uint64 getLatchDelay(const window_datum_type* dataPtr) const;
+    void latchPointer();
+    void recordInputEdge(const SDL_Event& event);
+    void snapshotInput();
+    void recoverTextures(window_datum_type* dataPtr);
+    const std::string& getAutoRenderDriver(Uint32 flags, RenderThread* thread);
+    static int findRenderDriver(const std::string& name);  // -1 if unknown
+    static Uint64 benchmarkRenderDriver(int index, Uint32 flags);  // 0 if unusable
+    void updateDisplayMode(window_datum_type* dataPtr);
+    void measureRefresh(window_datum_type* dataPtr, Uint64 doneHRC);
 
     void setFullscreen(window_datum_type* dataPtr,
                        bool enabled);
@@ -69,29 +276,145 @@ namespace jdi {
     
     void resizeWidgets(window_datum_type* dataPtr);
     void updateWidgets(window_datum_type* dataPtr);
+    void recordWidgets(window_datum_type* dataPtr);
+    bool beginScaledDraw(window_datum_type* dataPtr);
+    void endScaledDraw(window_datum_type* dataPtr);
+    void updateResolutionScale(window_datum_type* dataPtr, Uint64 drawHRC);
+    
+    // Recompute the window frame rate from its live animation demands
+    void updateAnimation(window_datum_type* dataPtr);
+    
+    // A frame period for the window, never shorter than its display refresh
+    Uint64 getFramePeriod(const window_datum_type* dataPtr,
+                          Uint32 ticksPerFrame) const;
     
-    void startAnimateCallback();
-    static Uint32 animateCallback(Uint32 interval, void* dummy);
-    void removeAnimateCallback();
+    // Ticks until the earliest deadline, 0 if due, -1 if idle
+    Sint32 getTicksToNextDeadline();
 
-    window_datum_type* getEventFocus(const SDL_Event& event);
+    // When the window next wants to draw, in HRC.  0 if it has nothing to do.
+    Uint64 getFrameDeadline(window_datum_type* dataPtr);
+    
+    // Wait for the first event of a pass, but no later than the earliest
+    // deadline or the timeout (-1 for none).  With nothing pending anywhere
+    // and no timeout this blocks in SDL_WaitEvent.  Returns false if no event
+    // arrived in time.
+    bool waitForEvent(SDL_Event& event, Sint32 timeoutTicks);
+    void waitForWake(Sint32 waitTicks);  // Headless counterpart, -1 for no limit
+    bool isFrameDue(window_datum_type* dataPtr, Uint64 now);
+    void drawDueWindows();
+
+    // Run every fixed simulation step that has come due
+    void runUpdates();
+
+    // The window an event is aimed at, or 0 for events aimed at everyone
+    static Uint32 getEventWindowID(const SDL_Event& event);
+    bool getEventPoint(const window_datum_type* dataPtr, const SDL_Event& event,
+                       SDL_Point& point) const;
+    void updateHover(window_datum_type* dataPtr, const std::vector<widget_ptr>& hits);
+    static int SDLCALL watchLiveResize(void* userdata, SDL_Event* event);
 
     bool sendEvent(window_datum_type* dataPtr,
                    SDL_Event* event);
+    bool sendFocusedEvent(window_datum_type* dataPtr, widget_ptr focus,
+                          SDL_Event* event, Uint32 eventClass);
+
+    void handleEvent(SDL_Event& event);
+    bool forwardEvent(const SDL_Event& event);
+
+    // Consecutive motion, wheel and finger motion events from one device in
+    // one window are merged while draining, and handled as one
+    SDL_Event              _coalescing;         // Merged so far; type 0 if none
+    std::vector<SDL_Event> _coalescingSamples;  // What went into it
+    std::vector<SDL_Event> _coalescedSamples;   // Behind the event being handled
+    bool                   _isCoalescing;
+
+    void dispatchEvent(SDL_Event& event);  // Handle now, or hold to merge
+    void flushCoalesced();
+    static bool canCoalesce(const SDL_Event& into, const SDL_Event& event);
+    static void coalesceEvent(SDL_Event& into, const SDL_Event& event);
     
     bool _willExit;
+
+    Uint32                _eventMask;  // Wanted by some widget in some window
+
+    Uint32                _jdiEventType;
+    engine_ptr::weak_type _self;
+
+    // Requests from other threads, applied by the engine thread each pass
+    typedef enum {
+      JDI_POST_CALL,
+      JDI_POST_UPDATE_WIDGET,
+      JDI_POST_RESIZE_WIDGET,
+      JDI_POST_UPDATE_WINDOW,
+      JDI_POST_RESIZE_WINDOW,
+      JDI_POST_UPDATE_ALL,
+      JDI_POST_RESIZE_ALL,
+    } post_kind_type;
+
+    struct post_datum_type {
+      post_kind_type         kind;
+      widget_ptr::weak_type  widget;
+      window_ptr::weak_type  window;
+      std::function<void()>  call;
+    };
+
+    MPSCQueue<post_datum_type> _posted;
+    std::atomic<bool>          _isWakePending;  // A JDI_WAKE is already queued
+    std::mutex                 _wakeMutex;      // Headless engines wake on these
+    std::condition_variable    _wakeSignal;     //   instead of a JDI_WAKE
+    std::atomic<SDL_threadID>  _threadID;       // The thread running the loop
+
+    void postRequest(post_datum_type&& request);
+    void sendWake();  // Unless one is already queued
+    void runPosted();
+
+    bool                       _isPipelined;  // A render thread per window
+    bool                       _isHeadless;
+
+    EventBus                   _bus;
+    Uint64                     _busFrameHRC;  // Next-frame messages last delivered
+
+    Uint64 getBusDeadline() const;  // When queued next-frame messages are due
+
+    std::unique_ptr<JobPool>   _jobs;           // Started on first use
+    std::once_flag             _jobsOnce;
+    size_t                     _jobThreads;
     
   protected:
-    Engine();
+    Engine(const EngineConfig& config);
     
   public:
     virtual ~Engine();
     Engine(const Engine&) = delete;
     Engine& operator=(const Engine&) = delete;
 
+    // Bring up a subsystem now if the engine config allows it.  Returns true
+    // if the subsystem is ready.  Anything calling into SDL_image, SDL_ttf or
+    // SDL_mixer directly should ask first.
+    static bool requireSubsystem(subsystem_type subsystem);
+    static bool isSubsystemReady(subsystem_type subsystem);
+    static Uint64 getSubsystemInitUSec(subsystem_type subsystem);  // 0 if never initialized
+
     bool areJoysticksEnabled() const;
     void enableJoysticks(bool enable);
 
+    // Keyboard, mouse and open joysticks as of the start of this pass.  Cheap
+    // to call; the same snapshot serves every onUpdate and onDraw of a pass.
+    const InputState& getInputState() const;
+
+    // Some window managers hold the event loop hostage while a window edge is
+    // dragged.  Live resize watches events as SDL queues them and lays out
+    // and draws the resized window on the spot, no faster than its frame
+    // rate.  Only events raised on the engine thread outside of a dispatch
+    // are acted on.
+    bool isLiveResizeEnabled() const;
+    void enableLiveResize(bool enable);
+
+    // Loaders which bring up their subsystem on demand
+    font_ptr  loadFont(const char* file, int ptSize, long index=0);
+    chunk_ptr loadChunk(const char* file);
+    music_ptr loadMusic(const char* file);
+
     void registerApp(const char* org,
                      const char* app);
     const std::filesystem::path& getBasePath() const;
@@ -109,6 +432,14 @@ namespace jdi {
                             Uint32 flags=SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI);
 
     void removeWindow(window_ptr window);
+
+    // Pick the renderer for a window, replacing the current one.  Widgets get
+    // onRenderUpdate(nullptr) first and must let go of the old renderer and
+    // its textures, then onRenderUpdate with the new one.  An unavailable
+    // driver falls back to SDL's choice.
+    void setWindowRenderer(window_ptr window, const std::string& driver, Uint32 flags=0);
+    std::string getRendererName(window_ptr window) const;  // Empty if none
+    Uint64      getBenchmarkCount() const;  // Times "auto" had to measure the drivers
     
     window_ptr getWindow(widget_ptr widget) const;
 
@@ -126,12 +457,101 @@ namespace jdi {
     void         setFocus(widget_ptr widget);
     void         clearFocus(window_ptr window);
 
+    // The frame rate caps how often a window redraws for requestUpdate(), and
+    // is the rate used by animation demands that don't name their own.
     Uint32       getFrameRate() const;                // Ticks-per-frame, all windows share
-    void         setFrameRate(Uint32 ticksPerFrame);  // 0 to disable all animation
+    void         setFrameRate(Uint32 ticksPerFrame);  // 0 to draw as soon as events are handled
+    Uint64       getMissedFrames() const;             // Frame deadlines skipped because we ran late
+
+    // A widget that is animating asks for frames; its window redraws at the
+    // fastest rate demanded of it until every demand is cancelled.  Demands die
+    // with their widget.  The widget must already be in a window.  With no
+    // demands and nothing to redraw, the main loop sleeps until an event.
+    bool         requestAnimation(widget_ptr widget,
+                                  Uint32 ticksPerFrame=0);  // 0 for the engine frame rate
+    void         cancelAnimation(widget_ptr widget);
+    bool         isAnimating(window_ptr window) const;
+
+    // The fixed-timestep update phase.  Every ticksPerUpdate, on the main
+    // thread, every simulating widget (Widget::setSimulating) in every window
+    // gets onUpdate(ticksPerUpdate), however fast or slow windows are
+    // drawing.  If the loop falls too far behind, the backlog is dropped
+    // rather than replayed.
+    Uint32       getUpdateRate() const;
+    void         setUpdateRate(Uint32 ticksPerUpdate);  // 0 to disable onUpdate
+    Uint64       getDroppedUpdates() const;
+
+    // While drawing, how far we are between the last update step and the next
+    // one, from 0 to 1.  Blend simulation states by this to draw smoothly.
+    float        getUpdateAlpha() const;
+
+    // Each pass of the main loop dispatches every pending event, up to these
+    // limits, before it lays out and draws each window at most once.
+    Uint32       getMaxEventsPerFrame() const;
+    Uint32       getMaxEventTicksPerFrame() const;
+    void         setEventBudget(Uint32 maxEvents,    // 0 for no cap
+                                Uint32 maxTicks=0);  // 0 for no time budget
+
+    // Coalescing.  Runs of mouse motion, wheel or finger motion events from
+    // the same device and window (and, for motion, the same buttons) reach
+    // widgets as one event per pass:  the latest position, with relative
+    // motion and wheel deltas summed.  Widgets which want the whole path,
+    // like drawing canvases, can ask while handling the merged event for
+    // the original samples, oldest first.  On by default.
+    bool         isCoalescing() const;
+    void         setCoalescing(bool enable);
+    const std::vector<SDL_Event>& getCoalescedEvents() const;  // Empty if not merged
 
     Uint64       getFPS(window_ptr window) const;     // The actual FPS drawn
     Uint64       getDrawTimeUSec(window_ptr window) const;  // An estimate of the window draw time, in microseconds.
+
+    // Per-window pacing.  Each window is paced to its own display and is
+    // drawn in deadline order.  The refresh period starts from the display's
+    // whole-Hz rate and is refined from back-to-back present times, so 59.94
+    // Hz displays don't drift.  Direct engines present one window after
+    // another on the engine thread, so a window blocked on vsync delays any
+    // other window that comes due meanwhile.  Pipelined engines present each
+    // window on a render thread of its own, where one window's vsync wait
+    // holds up no other.
+    int          getRefreshRate(window_ptr window) const;        // Display Hz, 0 if unknown
+    Uint64       getMissedFrames(window_ptr window) const;       // Animation deadlines skipped
+    Uint64       getFrameLateUSec(window_ptr window) const;      // Last frame start past its deadline
+    Uint64       getPresentTimeUSec(window_ptr window) const;    // Last time spent presenting
+
+    // Dynamic resolution.  While drawing a window (not counting the present,
+    // where vsync waits) runs over its frame budget, the engine draws it into
+    // an offscreen target at a reduced scale and stretches that to fit.  The
+    // scale steps down quickly, creeps back up once there is headroom, and
+    // never drops below floor.  Widgets still lay out and take input at full
+    // size, so isInside() and abs2Rel() are unaffected.  Pipelined windows
+    // always draw at full resolution.
+    void         setDynamicResolution(window_ptr window, bool enable, float floor=0.5f);
+    float        getResolutionScale(window_ptr window) const;    // 1 at full resolution
+
+    // After SDL_RENDER_DEVICE_RESET every sprite texture made by the window's
+    // renderer is rebuilt from its surface, a few milliseconds' worth per
+    // frame.  SDL_RENDER_TARGETS_RESET only needs a redraw.  Either way
+    // widgets hear about it through Widget::onRenderReset.
+    bool         isRecovering(window_ptr window) const;
+    Uint64       getRecoveryTimeUSec(window_ptr window) const;   // Last reset to fully rebuilt, 0 if none
+
+    // Input-to-photon latency:  from SDL's timestamp on an input event that
+    // was followed by a redraw of its window, to the end of that redraw's
+    // present.  Percentile in [0, 100] over the recent samples; 0 if none.
+    // SDL timestamps are in whole milliseconds, the rest is measured finely.
+    Uint64       getInputLatencyUSec(window_ptr window, float percentile=50.0f) const;
+    size_t       getInputLatencySamples(window_ptr window) const;
+
+    // Late latching.  Animating windows start each frame as late as they
+    // can, margin plus last frame's draw time before the next present
+    // deadline, and take in any pointer motion that arrived meanwhile right
+    // before drawing.  Needs the display refresh rate to be known.
+    bool         isLateLatched() const;
+    void         setLateLatch(bool enable, Uint32 marginUSec=2000);
     
+    // The request functions may be called from any thread.  Off the engine
+    // thread they are queued without locking and applied at the start of the
+    // next pass; the engine is woken once per batch, not once per request.
     void         requestResize(window_ptr window);
     void         requestResize(widget_ptr widget);
     void         requestResizeAll();
@@ -140,6 +560,33 @@ namespace jdi {
     void         requestUpdate(widget_ptr widget);
     void         requestUpdateAll();
 
+    // Run something on the engine thread at the start of the next pass.  Safe
+    // from any thread, including the engine thread itself.
+    void         post(std::function<void()> call);
+    bool         isEngineThread() const;  // Is this the thread running the loop?
+
+    // Run a job on the worker pool.  runJobThen() hands the job's result (if
+    // any) to a continuation on the engine thread, which is where renderers
+    // and textures may be touched.  If the job throws, fail gets the
+    // exception on the engine thread in place of the continuation; with no
+    // fail it is dropped, never thrown into the loop.  Job and continuation
+    // must be copyable; either function may be called from any thread.
+    void         runJob(JobPool::job_type job,
+                        job_priority_type priority = JDI_PRIORITY_NORMAL);
+    template <typename Job, typename Then>
+    void         runJobThen(Job job, Then then,
+                            JobPool::error_type fail = nullptr,
+                            job_priority_type priority = JDI_PRIORITY_NORMAL);
+    JobPool&     getJobPool();
+
+    // Typed messages between widgets, in place of user events broadcast to
+    // every widget.  Next-frame messages are delivered at the start of a
+    // pass, before its events, once a frame period (getFrameRate(), or 60 Hz
+    // without one) has passed since their last delivery; same-frame ones
+    // after this pass's updates and before it draws.  Queued messages wake
+    // the loop when they come due.
+    EventBus&    getEventBus();
+
     void         setFullscreen(window_ptr window,
                                bool enabled);
     void         setFullscreen(widget_ptr widget,
@@ -147,22 +594,88 @@ namespace jdi {
     void         toggleFullscreen(window_ptr window);
     void         toggleFullscreen(widget_ptr widget);
     
-    void         requestExit();    
-
-    void         mainLoop();  // Do the mainloop until someone requests an exit
+    void         requestExit();
+    void         clearExit();   // So step() can run again after an exit
+
+    // In pipelined mode widgets record each frame into a DrawList on the
+    // engine thread, and the window's own render thread, which owns its
+    // renderer, plays it back and presents.  Event handling and recording the next frame overlap with
+    // the present of the last one; each window has at most one frame in
+    // flight, though a frame holding any widget that still draws through
+    // onDraw is waited out.  The renderer handed to widget handlers then belongs to the
+    // render thread:  treat it as an identity only, and leave texture creation
+    // to DrawList::drawSprite().  SDL only promises rendering off the main
+    // thread for some drivers (not on macOS), so this is opt-in.
+    bool         isPipelined() const;    
+    bool         isHeadless() const;
+
+    // Do the mainloop until someone requests an exit, or, unless headless,
+    // until the last window is gone
+    void         mainLoop();
+
+    // For driving the engine from someone else's event loop.  One step waits
+    // up to timeoutTicks (-1 forever, 0 not at all) for an event or deadline,
+    // dispatches the pending events, runs due updates, and draws each due
+    // window at most once.  Returns false once the engine wants to exit.
+    bool         step(Sint32 timeoutTicks=-1);
+    bool         pumpOnce();  // step(0)
+
+    // Ticks until the next frame or update deadline, 0 if one is due now.
+    // SDL input has no file descriptor for a host reactor to wait on, so
+    // this never exceeds a short poll interval, even when idle; pass it to
+    // poll()/epoll_wait() and call step(0) when it expires.
+    Sint32       getTicksToDeadline();
     
-    static Uint32       getJDIEventType();
-    static engine_ptr   getEngine();
+    Uint32              getJDIEventType() const;  // Registered per engine
+
+    // The JDI_EVENTS_* class an SDL event type belongs to
+    static Uint32       getEventClass(Uint32 eventType);
+
+    // The shared engine, built on first call
+    static engine_ptr   getEngine(const EngineConfig& config=EngineConfig());
+    // A new engine independent of the shared one
+    static engine_ptr   create(const EngineConfig& config=EngineConfig());
     
   }; // end class Engine
 
 
 
+  inline EngineConfig::EngineConfig() :
+    controller(JDI_SUBSYSTEM_ON),
+    image(JDI_SUBSYSTEM_ON),
+    ttf(JDI_SUBSYSTEM_ON),
+    audio(JDI_SUBSYSTEM_ON),
+    imageFlags(IMG_INIT_PNG),
+    mixerFlags(MIX_INIT_OGG),
+    audioFrequency(48000),
+    audioFormat(AUDIO_F32SYS),
+    audioChannels(2),
+    audioChunkSize(1024),
+    jobThreads(0),
+    pipelined(false),
+    headless(false),
+    rendererDriver(),
+    rendererFlags(0) {}
+
+  inline subsystem_mode_type EngineConfig::getMode(subsystem_type subsystem) const {
+    switch(subsystem) {
+    case JDI_SUBSYSTEM_CONTROLLER: return(controller);
+    case JDI_SUBSYSTEM_IMAGE:      return(image);
+    case JDI_SUBSYSTEM_TTF:        return(ttf);
+    case JDI_SUBSYSTEM_AUDIO:      return(audio);
+    default:                       return(JDI_SUBSYSTEM_ON);
+    }
+  }
+  
   inline void Engine::toggleFullscreen(Engine::window_datum_type* dataPtr) {
     if(dataPtr != nullptr) setFullscreen(dataPtr, !dataPtr->isBorderlessFS);
   }
   
   inline bool Engine::areJoysticksEnabled() const { return(_joysticksEnabled); }
+
+  inline bool Engine::isLiveResizeEnabled() const { return(_liveResizeEnabled); }
+
+  inline const InputState& Engine::getInputState() const { return(_input); }
   
   inline const std::filesystem::path& Engine::getBasePath() const { return(_basePath); }  
   inline const std::filesystem::path& Engine::getPrefPath() const { return(_prefPath); }
@@ -173,10 +686,9 @@ namespace jdi {
     return(dataPtr == nullptr ? false : true);
   }
   
-  inline bool Engine::hasWindows() const { return(!_windowData.empty()); }
-  inline window_ptr Engine::getFirstWindow() const {
-    return(_windowData.empty() ? window_ptr() : _windowData.front().window);
-  }
+  inline Uint64 Engine::getBenchmarkCount() const { return(_benchmarkCount); }
+
+  inline bool Engine::hasWindows() const { return(!_windowByID.empty()); }
 
   inline window_ptr Engine::getWindow(widget_ptr widget) const {
     auto dataPtr = getDataByWidget(widget);
@@ -210,29 +722,141 @@ namespace jdi {
   
   inline Uint32 Engine::getFrameRate() const { return(_ticksPerFrame); }
 
-  inline void Engine::setFrameRate(Uint32 ticksPerFrame) {
-    _ticksPerFrame = ticksPerFrame;
+  inline Uint64 Engine::getMissedFrames() const { return(_missedFrames); }
+
+  inline Uint32 Engine::getUpdateRate() const { return(_ticksPerUpdate); }
+
+  inline void Engine::setUpdateRate(Uint32 ticksPerUpdate) {
+    _ticksPerUpdate = ticksPerUpdate;
+    _nextUpdateHRC = 0;  // Restart the schedule
+  }
+
+  inline Uint64 Engine::getDroppedUpdates() const { return(_droppedUpdates); }
+  inline float Engine::getUpdateAlpha() const { return(_updateAlpha); }
+
+  inline int Engine::getRefreshRate(window_ptr window) const {
+    auto dataPtr = getDataByWindow(window);
+
+    return(dataPtr == nullptr ? 0 : dataPtr->refreshRate);
+  }
+
+  inline Uint64 Engine::getMissedFrames(window_ptr window) const {
+    auto dataPtr = getDataByWindow(window);
+
+    return(dataPtr == nullptr ? 0 : dataPtr->missedFrames);
+  }
+
+  inline bool Engine::isAnimating(window_ptr window) const {
+    auto dataPtr = getDataByWindow(window);
+
+    return(dataPtr == nullptr ? false : dataPtr->animTicksPerFrame != 0);
+  }
+
+  inline Uint32 Engine::getMaxEventsPerFrame() const { return(_maxEventsPerFrame); }
+  inline Uint32 Engine::getMaxEventTicksPerFrame() const { return(_maxEventTicksPerFrame); }
+
+  inline void Engine::setEventBudget(Uint32 maxEvents,
+                                     Uint32 maxTicks) {
+    _maxEventsPerFrame = maxEvents;
+    _maxEventTicksPerFrame = maxTicks;
+  }
+
+  inline bool Engine::isCoalescing() const { return(_isCoalescing); }
+  inline void Engine::setCoalescing(bool enable) { _isCoalescing = enable; }
+
+  inline const std::vector<SDL_Event>& Engine::getCoalescedEvents() const {
+    return(_coalescedSamples);
   }
     
+  inline bool Engine::isPipelined() const { return(_isPipelined); }
+
+  inline bool Engine::isHeadless() const { return(_isHeadless); }
+
+  inline bool Engine::isLateLatched() const { return(_isLateLatched); }
+
+  inline bool Engine::isEngineThread() const { return(SDL_ThreadID() == _threadID.load()); }
+
+  inline void Engine::post(std::function<void()> call) {
+    postRequest(post_datum_type{JDI_POST_CALL, {}, {}, std::move(call)});
+  }
+  
+  inline EventBus& Engine::getEventBus() { return(_bus); }
+
+  inline void Engine::runJob(JobPool::job_type job, job_priority_type priority) {
+    getJobPool().submit(std::move(job), priority);
+  }
+
+  template <typename Job, typename Then>
+  inline void Engine::runJobThen(Job job, Then then, JobPool::error_type fail,
+                                 job_priority_type priority) {
+    typedef decltype(job()) result_type;
+
+    // The pool is joined before the engine goes, so this outlives the job
+    Engine* engine = this;
+    
+    getJobPool().submit([engine, job, then, fail]() mutable {
+        std::exception_ptr error;
+        
+        if constexpr(std::is_void<result_type>::value) {
+          try { job(); } catch(...) { error = std::current_exception(); }
+          engine->post([then, fail, error]() mutable {
+              if(!error) then();
+              else if(fail) fail(error);
+            });
+        } else {
+          std::shared_ptr<result_type> result;
+          try {
+            result = std::make_shared<result_type>(job());
+          } catch(...) {
+            error = std::current_exception();
+          }
+          engine->post([then, fail, result, error]() mutable {
+              if(!error) then(std::move(*result));
+              else if(fail) fail(error);
+            });
+        }
+      }, priority);
+  }
+  
   inline void Engine::requestResize(window_ptr window) {
+    if(!isEngineThread()) {
+      postRequest(post_datum_type{JDI_POST_RESIZE_WINDOW, {}, window});
+      return;
+    }
+    
     auto dataPtr = getDataByWindow(window);
 
     if(dataPtr != nullptr) { dataPtr->willResize = true; }
   }
 
   inline void Engine::requestResize(widget_ptr widget) {
+    if(!isEngineThread()) {
+      postRequest(post_datum_type{JDI_POST_RESIZE_WIDGET, widget});
+      return;
+    }
+    
     auto dataPtr = getDataByWidget(widget);
 
     if(dataPtr != nullptr) { dataPtr->willResize = true; }
   }
 
   inline void Engine::requestUpdate(window_ptr window) {
+    if(!isEngineThread()) {
+      postRequest(post_datum_type{JDI_POST_UPDATE_WINDOW, {}, window});
+      return;
+    }
+    
     auto dataPtr = getDataByWindow(window);
 
     if(dataPtr != nullptr) { dataPtr->willUpdate = true; }
   }
 
   inline void Engine::requestUpdate(widget_ptr widget) {
+    if(!isEngineThread()) {
+      postRequest(post_datum_type{JDI_POST_UPDATE_WIDGET, widget});
+      return;
+    }
+    
     auto dataPtr = getDataByWidget(widget);
 
     if(dataPtr != nullptr) { dataPtr->willUpdate = true; }
@@ -257,5 +881,10 @@ namespace jdi {
   }
   
   inline void Engine::requestExit() { _willExit = true; }
+  inline void Engine::clearExit() { _willExit = false; }
+
+  inline Uint32 Engine::getJDIEventType() const { return(_jdiEventType); }
+
+  inline bool Engine::pumpOnce() { return(step(0)); }
   
 }
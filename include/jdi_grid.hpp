@@ -37,6 +37,7 @@ namespace jdi {
     Grid& operator=(const Grid&) = delete;
 
     virtual void onDraw(renderer_ptr renderer);
+    virtual void onRecord(DrawList& list);
     virtual void onResize(renderer_ptr renderer);
     
     virtual bool hasChildren() const;
@@ -0,0 +1,54 @@
+// File: jdi_hitindex.hpp
+// ----
+// A uniform grid over a widget tree's draw rects, for finding what is under
+// the pointer without visiting every widget.
+
+namespace jdi {
+
+  ////
+  // Widgets are numbered in pre-order, so a higher number is drawn later:
+  // descendants beat their ancestors and later siblings beat earlier ones.
+  // Only widgets shown when the index was built are in it.  Built from the
+  // draw rects as they were; rebuild after layout.
+  ////
+  class HitIndex {
+  public:
+    typedef std::vector<int> index_seq_type;
+
+  private:
+    std::vector<widget_ptr::weak_type>        _widgets;  // By pre-order number
+    std::unordered_map<const Widget*, int>    _numbers;
+    std::vector<index_seq_type>               _cells;
+    SDL_Rect                                  _bounds;
+    int                                       _cols;
+    int                                       _rows;
+    bool                                      _isBuilt;
+
+    static bool isShown(const widget_ptr& widget);
+
+  public:
+    HitIndex();
+
+    void rebuild(widget_ptr root, const SDL_Rect* bounds);
+    void clear();
+    bool isBuilt() const;
+
+    // Widgets under the point and every one of their ancestors, topmost
+    // first.  Replaces what was in hits.
+    void hitTest(const SDL_Point* point, std::vector<widget_ptr>& hits) const;
+
+    int getNumber(const Widget* widget) const;  // -1 if not indexed
+  }; // end class HitIndex
+
+
+  ////
+  // Inline
+  ////
+  inline bool HitIndex::isBuilt() const { return(_isBuilt); }
+
+  inline int HitIndex::getNumber(const Widget* widget) const {
+    auto found = _numbers.find(widget);
+    return(found == _numbers.end() ? -1 : found->second);
+  }
+
+} // end namespace jdi
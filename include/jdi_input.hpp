@@ -0,0 +1,114 @@
+// File: jdi_input.hpp
+// ----
+// A snapshot of the keyboard, mouse and joysticks, taken once a pass.
+
+namespace jdi {
+
+  ////
+  // What the input devices looked like at the start of this pass, for widgets
+  // which would rather ask "is it held?" than follow every event.  The engine
+  // builds one after draining events and before updates and draws; it does
+  // not change until the next pass.
+  //
+  // Held states are polled.  Pressed and released edges also come from the
+  // events of the pass, so a tap shorter than a pass still shows up as both.
+  // Game controllers appear as the joysticks they are built on.
+  ////
+  class InputState {
+  public:
+    struct joystick_state_type {
+      SDL_JoystickID      id;
+      std::vector<Sint16> axes;
+      std::vector<Uint8>  hats;
+      std::vector<Uint8>  buttons;   // Held
+      std::vector<Uint8>  pressed;   // Went down this pass
+      std::vector<Uint8>  released;  // Went up this pass
+    };
+
+    typedef std::vector<joystick_state_type> joystick_state_seq_type;
+
+  private:
+    std::vector<Uint8> _keys;          // By scancode
+    std::vector<Uint8> _keysPressed;
+    std::vector<Uint8> _keysReleased;
+    Uint16             _modifiers;     // KMOD_*
+
+    int    _mouseX;
+    int    _mouseY;
+    Uint32 _mouseWindowID;             // 0 if the mouse is over none of ours
+    Uint32 _buttons;                   // SDL_BUTTON() masks
+    Uint32 _buttonsPressed;
+    Uint32 _buttonsReleased;
+    Sint32 _wheelX;                    // Summed over the pass
+    Sint32 _wheelY;
+
+    joystick_state_seq_type _joysticks;
+    Uint64                  _serial;   // Counts snapshots
+
+    friend class Engine;
+
+    void clearEdges();
+    static bool getFlag(const std::vector<Uint8>& flags, int index);
+
+  public:
+    InputState();
+
+    Uint64 getSerial() const;
+
+    bool   isKeyHeld(SDL_Scancode key) const;
+    bool   wasKeyPressed(SDL_Scancode key) const;
+    bool   wasKeyReleased(SDL_Scancode key) const;
+    Uint16 getModifiers() const;
+
+    int    getMouseX() const;
+    int    getMouseY() const;
+    Uint32 getMouseWindowID() const;
+    bool   isButtonHeld(int button) const;      // SDL_BUTTON_LEFT, ...
+    bool   wasButtonPressed(int button) const;
+    bool   wasButtonReleased(int button) const;
+    Sint32 getWheelX() const;
+    Sint32 getWheelY() const;
+
+    const joystick_state_seq_type& getJoysticks() const;
+    const joystick_state_type*     getJoystick(SDL_JoystickID id) const;  // nullptr if not open
+  }; // end class InputState
+
+
+  ////
+  // Inline
+  ////
+  inline bool InputState::getFlag(const std::vector<Uint8>& flags, int index) {
+    return(index >= 0 && size_t(index) < flags.size() && flags[index] != 0);
+  }
+
+  inline Uint64 InputState::getSerial() const { return(_serial); }
+
+  inline bool InputState::isKeyHeld(SDL_Scancode key) const { return(getFlag(_keys, key)); }
+  inline bool InputState::wasKeyPressed(SDL_Scancode key) const { return(getFlag(_keysPressed, key)); }
+  inline bool InputState::wasKeyReleased(SDL_Scancode key) const { return(getFlag(_keysReleased, key)); }
+  inline Uint16 InputState::getModifiers() const { return(_modifiers); }
+
+  inline int InputState::getMouseX() const { return(_mouseX); }
+  inline int InputState::getMouseY() const { return(_mouseY); }
+  inline Uint32 InputState::getMouseWindowID() const { return(_mouseWindowID); }
+
+  inline bool InputState::isButtonHeld(int button) const {
+    return((_buttons & SDL_BUTTON(button)) != 0);
+  }
+
+  inline bool InputState::wasButtonPressed(int button) const {
+    return((_buttonsPressed & SDL_BUTTON(button)) != 0);
+  }
+
+  inline bool InputState::wasButtonReleased(int button) const {
+    return((_buttonsReleased & SDL_BUTTON(button)) != 0);
+  }
+
+  inline Sint32 InputState::getWheelX() const { return(_wheelX); }
+  inline Sint32 InputState::getWheelY() const { return(_wheelY); }
+
+  inline const InputState::joystick_state_seq_type& InputState::getJoysticks() const {
+    return(_joysticks);
+  }
+
+} // end namespace jdi
@@ -0,0 +1,68 @@
+// File: jdi_jobs.hpp
+// ----
+// A pool of worker threads which share out jobs by stealing.
+
+namespace jdi {
+
+  typedef enum {
+    JDI_PRIORITY_HIGH = 0,
+    JDI_PRIORITY_NORMAL,
+    JDI_PRIORITY_LOW,
+    JDI_PRIORITY_COUNT
+  } job_priority_type;
+
+  ////
+  // Each worker keeps its own deque per priority.  A worker runs its newest
+  // job first (it is likely still warm in cache) and, when it runs dry,
+  // steals the oldest job from another worker.  Higher priorities always go
+  // before lower ones, across all workers.  Jobs submitted from inside a job
+  // land on the submitting worker's deque; others are dealt out in turn.
+  //
+  // Jobs run on worker threads, so they must not touch renderers, textures
+  // or windows.  Use Engine::runJobThen() to get a continuation back on the
+  // engine thread for that part.  A job which throws is dropped.
+  ////
+  class JobPool {
+  public:
+    typedef std::function<void()> job_type;
+    typedef std::function<void(std::exception_ptr)> error_type;
+
+  private:
+    struct worker_type {
+      std::mutex            mutex;
+      std::deque<job_type>  jobs[JDI_PRIORITY_COUNT];
+      std::thread           thread;
+    };
+
+    std::vector<std::unique_ptr<worker_type>> _workers;
+    std::mutex                                _sleepMutex;
+    std::condition_variable                   _wake;
+    std::atomic<size_t>                       _pendingJobs;  // Queued, not yet started
+    std::atomic<size_t>                       _nextWorker;   // For outside submissions
+    bool                                      _willStop;     // Guarded by _sleepMutex
+
+    bool takeJob(size_t self, job_type& job);
+    void runWorker(size_t self);
+
+  public:
+    // Zero threads picks one fewer than the hardware threads, at least one
+    JobPool(size_t threadCount = 0);
+    ~JobPool();  // Queued jobs are dropped; running ones finish
+    JobPool(const JobPool&) = delete;
+    JobPool& operator=(const JobPool&) = delete;
+
+    void   submit(job_type job, job_priority_type priority = JDI_PRIORITY_NORMAL);
+    size_t getThreadCount() const;
+    size_t getPendingJobs() const;
+    bool   isWorkerThread() const;  // Is the caller one of this pool's workers?
+  }; // end class JobPool
+
+
+  ////
+  // Inline
+  ////
+  inline size_t JobPool::getThreadCount() const { return(_workers.size()); }
+
+  inline size_t JobPool::getPendingJobs() const { return(_pendingJobs.load()); }
+
+} // end namespace jdi
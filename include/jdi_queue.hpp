@@ -0,0 +1,94 @@
+// File: jdi_queue.hpp
+// ----
+// A lock-free queue with many producers and a single consumer.
+
+namespace jdi {
+
+  ////
+  // Any thread may push; only one thread at a time may pop.  Pushing never
+  // blocks or spins.  A pop can come up empty while a push is half-way done;
+  // the item shows up on a later pop.  (This is Dmitry Vyukov's intrusive
+  // MPSC node queue.)
+  ////
+  template <typename T>
+  class MPSCQueue {
+  private:
+    struct node_type {
+      std::atomic<node_type*> next;
+      T                       value;
+    };
+
+    std::atomic<node_type*> _head;  // Most recently pushed; producers swap here
+    node_type*              _tail;  // Next to pop; consumer only
+    node_type               _stub;
+
+    void pushNode(node_type* node);
+
+  public:
+    MPSCQueue();
+    ~MPSCQueue();
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+    void push(T value);    // Any thread
+    bool pop(T& value);    // Consumer thread only.  False if nothing is ready.
+  }; // end class MPSCQueue
+
+
+  template <typename T>
+  inline MPSCQueue<T>::MPSCQueue() :
+    _head(&_stub),
+    _tail(&_stub) {
+    _stub.next.store(nullptr, std::memory_order_relaxed);
+  }
+
+  template <typename T>
+  inline MPSCQueue<T>::~MPSCQueue() {
+    T value;
+    while(pop(value)) {}
+  }
+
+  template <typename T>
+  inline void MPSCQueue<T>::pushNode(node_type* node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    node_type* prev = _head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  template <typename T>
+  inline void MPSCQueue<T>::push(T value) {
+    node_type* node = new node_type;
+    node->value = std::move(value);
+    pushNode(node);
+  }
+
+  template <typename T>
+  inline bool MPSCQueue<T>::pop(T& value) {
+    node_type* tail = _tail;
+    node_type* next = tail->next.load(std::memory_order_acquire);
+
+    if(tail == &_stub) {
+      if(next == nullptr) return(false);  // Empty
+      _tail = next;
+      tail = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+
+    if(next == nullptr) {
+      if(tail != _head.load(std::memory_order_acquire)) {
+        return(false);  // A producer is mid-push; try again later
+      }
+
+      // Tail is the last real node.  Put the stub behind it so it can go.
+      pushNode(&_stub);
+      next = tail->next.load(std::memory_order_acquire);
+      if(next == nullptr) return(false);
+    }
+
+    _tail = next;
+    value = std::move(tail->value);
+    delete tail;
+    return(true);
+  }
+
+} // end namespace jdi
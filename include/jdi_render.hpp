@@ -0,0 +1,148 @@
+// File: jdi_render.hpp
+// ----
+// Recorded draw commands, and a thread to play them back.
+
+namespace jdi {
+
+  ////
+  // A frame's worth of drawing, recorded on the engine thread and replayed
+  // onto a renderer later, possibly on another thread.  Sprites and textures
+  // are held until the list goes away.  A sprite with no texture yet gets
+  // one from the replaying renderer, so widgets never need to touch the
+  // renderer themselves.  A list bound for another thread has its sprites
+  // swapped for their textures first (resolveSprites()), so that thread
+  // never touches a Sprite the engine thread may be changing.
+  ////
+  class DrawList {
+  public:
+    typedef std::function<void(renderer_ptr)> call_type;
+
+  private:
+    typedef enum {
+      JDI_DRAW_COLOR,
+      JDI_DRAW_CLEAR,
+      JDI_DRAW_FILL,
+      JDI_DRAW_RECT,
+      JDI_DRAW_LINE,
+      JDI_DRAW_CLIP,
+      JDI_DRAW_UNCLIP,
+      JDI_DRAW_SPRITE,
+      JDI_DRAW_TEXTURE,
+      JDI_DRAW_CALL,
+      JDI_DRAW_NOTHING,  // A sprite with nothing to show
+    } op_type;
+
+    struct command_type {
+      op_type  op;
+      SDL_Rect tgt;    // Lines use x,y to w,h
+      SDL_Rect src;    // Textures:  w == 0 for all of it.  Sprites:  x is the element
+      Color    color;
+      int      index;  // Into _sprites, _textures or _calls
+    };
+
+    std::vector<command_type> _commands;
+    std::vector<sprite_ptr>   _sprites;
+    std::vector<texture_ptr>  _textures;
+    std::vector<call_type>    _calls;
+    bool                      _isSynced;  // Has calls the engine must wait for
+
+    void add(op_type op, const SDL_Rect* tgt=nullptr, const SDL_Rect* src=nullptr,
+             int index=0);
+
+  public:
+    DrawList();
+
+    void setColor(const Color& color);
+    void clear();
+    void fillRect(const SDL_Rect* rect);
+    void drawRect(const SDL_Rect* rect);
+    void drawLine(int x1, int y1, int x2, int y2);
+    void setClip(const SDL_Rect* rect);  // nullptr to stop clipping
+    void drawSprite(sprite_ptr sprite, const SDL_Rect* tgtRect, int element=0);
+    void drawTexture(texture_ptr texture, const SDL_Rect* srcRect,
+                     const SDL_Rect* tgtRect);
+
+    // Escape hatch:  run arbitrary drawing at this point of the replay, on
+    // the replaying thread.
+    void call(call_type call);
+
+    // Same, but the engine thread waits out the replay, so the call may read
+    // anything the engine thread owns.  Costs the frame its overlap.
+    void callSynced(call_type call);
+
+    void reset();  // Empty the list, keeping its storage
+    bool isEmpty() const;
+    size_t getCommandCount() const;
+    bool isSynced() const;
+
+    // On the engine thread, before handing the list over.  Missing textures
+    // are made through thread, which owns renderer (nullptr to make them
+    // here).
+    void resolveSprites(renderer_ptr renderer, RenderThread* thread);
+
+    void replay(renderer_ptr renderer);
+  }; // end class DrawList
+
+
+  ////
+  // One thread which owns renderers and runs tasks for them in order.  SDL
+  // wants each renderer used from one thread only; everything touching a
+  // renderer owned here, including creating and destroying it, has to go
+  // through run() or runAndWait().
+  ////
+  class RenderThread {
+  public:
+    typedef std::function<void()> task_type;
+
+  private:
+    std::thread             _thread;
+    std::mutex              _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    std::deque<task_type>   _tasks;
+    bool                    _willStop;
+
+    void runThread();
+
+  public:
+    RenderThread();
+    ~RenderThread();  // Finishes every queued task first
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    void run(task_type task);
+    void runAndWait(task_type task);  // Exceptions come back to the caller
+    bool isRenderThread() const;
+  }; // end class RenderThread
+
+
+  ////
+  // Inline
+  ////
+  inline void DrawList::setColor(const Color& color) {
+    add(JDI_DRAW_COLOR);
+    _commands.back().color = color;
+  }
+
+  inline void DrawList::clear() { add(JDI_DRAW_CLEAR); }
+
+  inline void DrawList::fillRect(const SDL_Rect* rect) { add(JDI_DRAW_FILL, rect); }
+
+  inline void DrawList::drawRect(const SDL_Rect* rect) { add(JDI_DRAW_RECT, rect); }
+
+  inline void DrawList::drawLine(int x1, int y1, int x2, int y2) {
+    SDL_Rect ends = {x1, y1, x2, y2};
+    add(JDI_DRAW_LINE, &ends);
+  }
+
+  inline void DrawList::setClip(const SDL_Rect* rect) {
+    add(rect == nullptr ? JDI_DRAW_UNCLIP : JDI_DRAW_CLIP, rect);
+  }
+
+  inline bool DrawList::isEmpty() const { return(_commands.empty()); }
+
+  inline size_t DrawList::getCommandCount() const { return(_commands.size()); }
+
+  inline bool DrawList::isSynced() const { return(_isSynced); }
+
+} // end namespace jdi
@@ -4,17 +4,22 @@
 
 namespace jdi {
 
-  class Sprite {
+  ////
+  // Shared sprites remember which renderer made their texture, so the engine
+  // can rebuild just those after the renderer loses its device.
+  ////
+  class Sprite : public std::enable_shared_from_this<Sprite> {
   private:
     surface_ptr _surface;  // CPU-bound representation of the sprite
     texture_ptr _texture;  // GPU-bound representation of the sprite
+    renderer_ptr::weak_type _textureRenderer;  // Which renderer made _texture
     int _w;                 // Width of one element
     int _h;                 // Height of one element
     int _rows;              // Number of rows of elements in the surface
     int _cols;              // Number of cols of elements in the surface
 
   public:
-    Sprite() = default;
+    Sprite();
     Sprite(const Sprite&) = delete;
     virtual ~Sprite();
     Sprite& operator=(const Sprite&) = delete;
@@ -30,6 +35,10 @@ namespace jdi {
     
     texture_ptr getTexture() const;
     texture_ptr generateTexture(renderer_ptr renderer);
+    bool        hasTextureFrom(const renderer_ptr& renderer) const;
+
+    // Every live shared sprite holding a texture made by renderer
+    static std::vector<sprite_ptr> getTexturedSprites(const renderer_ptr& renderer);
 
     int getElementWidth() const;
     int getElementHeight() const;
@@ -117,6 +126,16 @@ namespace jdi {
                                       int elementW = 0,
                                       int elementH = 0);
 
+    // Decode on the engine's job pool and hand the sprite to then() on the
+    // engine thread, ready for generateTexture().  A failed load calls
+    // fail(), if given, on the engine thread instead.
+    static void createFromImageAsync(engine_ptr engine,
+                                     const char* file,
+                                     std::function<void(sprite_ptr)> then,
+                                     int elementW = 0,
+                                     int elementH = 0,
+                                     JobPool::error_type fail = nullptr);
+
   }; // end class Sprite
 
   ////
@@ -126,13 +145,12 @@ namespace jdi {
   
   inline texture_ptr Sprite::getTexture() const { return(_texture); }
   
-  inline texture_ptr Sprite::generateTexture(renderer_ptr renderer) {
-    _texture.reset();
-    if(renderer && _surface) {
-      _texture = sdl_shared(SDL_CreateTextureFromSurface(renderer.get(),
-                                                         _surface.get()));
-    }
-    return(_texture);
+  // By owner rather than address:  a renderer made after another went away
+  // may well land at the same address.
+  inline bool Sprite::hasTextureFrom(const renderer_ptr& renderer) const {
+    return(_texture && renderer &&
+           !_textureRenderer.owner_before(renderer) &&
+           !renderer.owner_before(_textureRenderer));
   }
 
   inline int Sprite::getElementWidth() const {
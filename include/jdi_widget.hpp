@@ -12,6 +12,10 @@ namespace jdi {
     bool _isEnabled;  // Does this widget receive events?
     bool _isVisible;  // Does this widget appear when rendered?
 
+    Uint32 _eventMask;  // JDI_EVENTS_* classes onEvent wants
+    bool   _isShortcutListener;  // Hears keys nobody on the focus path took
+    bool   _isSimulating;        // Gets onUpdate
+
     // Minimum padding in each direction.
     int _padN;
     int _padS;
@@ -34,6 +38,14 @@ namespace jdi {
     // Hierarchy is useful
     widget_ptr::weak_type _self;
     widget_ptr::weak_type _parent;
+
+    // SDL ID of the window whose tree holds this widget, or 0 if none, and
+    // the engine which owns that window.  Kept current by the engine
+    // (setRoot, removeWindow) and by claimChild.
+    Uint32                _windowID;
+    engine_ptr::weak_type _engine;
+
+    friend class Engine;
     
   protected:
     Widget();
@@ -53,6 +65,23 @@ namespace jdi {
     
     bool isVisible() const;
     void setVisible(bool visible);
+
+    // Which classes of event reach onEvent (JDI_EVENTS_*, ORed).  Everything
+    // by default.  The engine only visits subscribers, and once no widget of
+    // any window wants touch, drop or joystick motion events, SDL stops
+    // queueing them at all.
+    Uint32 getEventMask() const;
+    void setEventMask(Uint32 mask);
+
+    // Key and text events travel the focus path only (see onCaptureEvent).
+    // Shortcut listeners anywhere in the window get the ones which come back
+    // unhandled, in post-order.  Off by default.
+    bool isShortcutListener() const;
+    void setShortcutListener(bool listen);
+
+    // Only simulating widgets get onUpdate.  Off by default.
+    bool isSimulating() const;
+    void setSimulating(bool simulate);
     
     int getPadding(direction_type direction) const;  // Sum of direction paddings
     // Set all requested direction pads to be the given size
@@ -88,17 +117,45 @@ namespace jdi {
 
     // When the renderer has been updated.  Can be nullptr if there is no
     // longer a renderer.  This is a good time to set up any textures and get
-    // them ready for use.
+    // them ready for use.  Resizing the window keeps its renderer, so you only
+    // get this when you join a window or its renderer is really replaced;
+    // size changes come through onResize.
     //
     // You are NOT responsible for propagating this to your children
     virtual void onRenderUpdate(renderer_ptr renderer);
 
+    // The renderer lost the contents of its render targets or, if
+    // isDeviceLost, all of its textures.  Sprite textures are rebuilt for you
+    // over the next few frames; anything else you made from the renderer is
+    // yours to redo.
+    //
+    // You are NOT responsible for propagating this to your children
+    virtual void onRenderReset(renderer_ptr renderer, bool isDeviceLost);
+
     // When it's time to draw something.  Renderer is always defined.  Your
-    // DrawRect has already been set.  Have at it!
+    // DrawRect has already been set.  Have at it!  If you simulate in
+    // onUpdate, Engine::getUpdateAlpha() says how far to blend toward the
+    // next step.
     //
     // You ARE responsible for propagating this to your children
     virtual void onDraw(renderer_ptr renderer);
 
+    // Pipelined engines (EngineConfig::pipelined) call this instead of
+    // onDraw.  Record what you would draw; it is played back later on the
+    // render thread.  The default records a synced call to onDraw there
+    // (see DrawList::callSynced), which is safe but makes the engine wait for
+    // the frame; override this to get the overlap back.
+    //
+    // You ARE responsible for propagating this to your children
+    virtual void onRecord(DrawList& list);
+
+    // One fixed simulation step of the given length has passed (see
+    // Engine::setUpdateRate).  Advance your state.  Don't draw; ask for an
+    // update if you need one.  Only called once you setSimulating(true).
+    //
+    // You are NOT responsible for propagating this to your children
+    virtual void onUpdate(Uint32 ticks);
+
     // This lets you know that your size has (potentially) been changed, in
     // case you need to make changes to any of your data structures.  Don't
     // actually render anything, though -- you'll get an onDraw if that is
@@ -121,9 +178,29 @@ namespace jdi {
     // Something happened.  You can do something with the information.  Return
     // true if the event should stop propagating, false otherwise.
     //
+    // Key and text events go to the focused widget (the root if nothing has
+    // focus), then bubble up through its ancestors, then go to shortcut
+    // listeners.
+    //
     // You are NOT responsible for propagating this to your children.
     virtual bool onEvent(renderer_ptr renderer,
                          SDL_Event* event);
+
+    // Key and text events on their way down to the focused widget, visiting
+    // its ancestors from the root first.  Return true to take the event
+    // before the focused widget ever sees it.
+    //
+    // You are NOT responsible for propagating this to your children.
+    virtual bool onCaptureEvent(renderer_ptr renderer,
+                                SDL_Event* event);
+
+    // Pointer events (mouse and touch) only reach the widgets under the
+    // pointer, their ancestors, and the focus tree.  These tell you when the
+    // mouse comes over your draw rect and when it goes.
+    //
+    // You are NOT responsible for propagating these to your children.
+    virtual void onMouseEnter(renderer_ptr renderer);
+    virtual void onMouseLeave(renderer_ptr renderer);
     
     ////
     // Self -- For canonicalization
@@ -153,6 +230,13 @@ namespace jdi {
     ////
     widget_ptr getParent() const;
     widget_ptr getRoot() const;  // As far up the tree as you can go
+
+    // The SDL window ID of the window displaying this widget, or 0 if it is
+    // not (yet) part of a window's tree.  Constant time.
+    Uint32 getWindowID() const;
+
+    // The engine owning that window, or nullptr if there is no window.
+    engine_ptr getEngine() const;
     
   }; // end class Widget
 
@@ -162,7 +246,10 @@ namespace jdi {
   inline void Widget::setEnabled(bool enabled) { _isEnabled = enabled; }
 
   inline bool Widget::isVisible() const { return(_isVisible); }
-  inline void Widget::setVisible(bool visible) { _isVisible = visible; }
+
+  inline Uint32 Widget::getEventMask() const { return(_eventMask); }
+  inline bool Widget::isShortcutListener() const { return(_isShortcutListener); }
+  inline bool Widget::isSimulating() const { return(_isSimulating); }
 
   inline int Widget::getMinW() const { return(_minW); }
   inline int Widget::getMinH() const { return(_minH); }
@@ -199,5 +286,7 @@ namespace jdi {
   
   inline widget_ptr Widget::getSelf() const { return(_self.lock()); }
   inline widget_ptr Widget::getParent() const { return(_parent.lock()); }
+  inline Uint32 Widget::getWindowID() const { return(_windowID); }
+  inline engine_ptr Widget::getEngine() const { return(_engine.lock()); }
 
 } // end namespace jdi
@@ -0,0 +1,53 @@
+// File: jdi_bus.cpp
+// ----
+// Typed messages between widgets.
+
+#include "jdi.hpp"
+
+namespace jdi {
+
+  // Same-frame handlers which keep publishing same-frame messages get this
+  // many rounds before the rest waits for the next pass
+  const int maxSameFrameRounds = 8;
+
+  std::atomic<size_t> EventBus::_typeCount(0);
+
+  EventBus::EventBus() :
+    _nextSubscription(1)
+  {}
+
+  bool EventBus::isEnabled(const widget_ptr& owner) { return(owner->isEnabled()); }
+
+  void EventBus::unsubscribe(subscription_type subscription) {
+    for(auto& channel : _channels) {
+      if(channel && channel->unsubscribe(subscription)) return;
+    }
+  }
+
+  void EventBus::unsubscribe(widget_ptr owner) {
+    if(!owner) return;
+    
+    for(auto& channel : _channels) {
+      if(channel) channel->unsubscribe(owner.get());
+    }
+  }
+
+  void EventBus::deliver(delivery_type phase) {
+    // Handlers may subscribe to new types, growing _channels, so go by index
+    for(int round = 0; round < maxSameFrameRounds; ++round) {
+      bool isDelivered = false;
+      for(size_t index = 0; index < _channels.size(); ++index) {
+        if(_channels[index] && _channels[index]->deliver(phase)) isDelivered = true;
+      }
+      if(!isDelivered || phase == JDI_DELIVER_NEXT_FRAME) return;
+    }
+  }
+
+  bool EventBus::hasQueued(delivery_type when) const {
+    for(auto& channel : _channels) {
+      if(channel && channel->hasQueued(when)) return(true);
+    }
+    return(false);
+  }
+
+} // end namespace jdi
@@ -3,6 +3,10 @@
 // Handle SDL init/mainloop/destroy; and other goodies.
 
 
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+
 #include "jdi.hpp"
 
 namespace jdi {
@@ -13,6 +17,123 @@ namespace jdi {
     return(_hiddenEngine);
   }
 
+  // SDL subsystems are process-wide, so their bookkeeping is too
+  struct subsystem_state_type {
+    std::mutex          mutex;
+    int                 engineCount;
+    EngineConfig        config;  // From the first engine
+    std::vector<std::pair<const Engine*, EngineConfig>> configs;  // Of the live engines
+    subsystem_mode_type mode[JDI_SUBSYSTEM_COUNT];
+    bool                isReady[JDI_SUBSYSTEM_COUNT];
+    Uint64              initHRC[JDI_SUBSYSTEM_COUNT];
+  };
+
+  subsystem_state_type& getSubsystemState() {
+    static subsystem_state_type _state{};
+
+    return(_state);
+  }
+
+  // SDL has one event queue and one event filter per process, so this
+  // serves every engine at once
+  struct event_filter_state_type {
+    std::mutex           mutex;
+    std::vector<Engine*> engines;
+    std::unordered_map<Uint32, Engine*> windowOwners;  // By window ID
+    std::atomic<Uint32>  eventMask;     // Union of the engines' masks
+    SDL_EventFilter      previous;      // Whoever had the filter before us
+    void*                previousData;
+  };
+
+  event_filter_state_type& getEventFilterState() {
+    static event_filter_state_type _state{};
+
+    return(_state);
+  }
+
+  // Position of a single JDI_EVENTS_* bit
+  int getEventClassIndex(Uint32 eventClass) {
+    int index = 0;
+    while(index + 1 < JDI_EVENT_CLASS_COUNT && (eventClass >> index) != 1) ++index;
+    return(index);
+  }
+
+  // Would the widget take this class of event right now?
+  bool isListening(const widget_ptr& widget, Uint32 eventClass) {
+    return(widget->isEnabled() && (widget->getEventMask() & eventClass) != 0);
+  }
+
+  // Is widget top, or somewhere beneath it?
+  bool isWithin(widget_ptr widget, const widget_ptr& top) {
+    for(; widget; widget = widget->getParent()) {
+      if(widget == top) return(true);
+    }
+    return(false);
+  }
+
+  int modePermissiveness(subsystem_mode_type mode) {
+    return(mode == JDI_SUBSYSTEM_ON   ? 2
+           : mode == JDI_SUBSYSTEM_LAZY ? 1
+           : 0);
+  }
+
+  // A subsystem is allowed while any live engine allows it.  Call locked.
+  void mergeModes(subsystem_state_type& state) {
+    for(int subsystem = 0; subsystem < JDI_SUBSYSTEM_COUNT; ++subsystem) {
+      subsystem_mode_type merged = JDI_SUBSYSTEM_OFF;
+      for(auto& entry : state.configs) {
+        subsystem_mode_type mode = entry.second.getMode(subsystem_type(subsystem));
+        if(modePermissiveness(mode) > modePermissiveness(merged)) merged = mode;
+      }
+      state.mode[subsystem] = merged;
+    }
+  }
+
+  void forgetConfig(subsystem_state_type& state, const Engine* engine) {
+    auto& configs = state.configs;
+    configs.erase(std::remove_if(configs.begin(), configs.end(),
+                                 [engine](const std::pair<const Engine*, EngineConfig>& entry) {
+                                   return(entry.first == engine);
+                                 }),
+                  configs.end());
+    mergeModes(state);
+  }
+
+  // Animation demands which don't name a rate, when the engine has none either
+  const Uint32 defaultTicksPerFrame = 1000/60;
+
+  // Longest getTicksToDeadline() hands a host loop, so that it comes back
+  // to pump SDL input
+  const Sint32 maxHostWaitTicks = 10;
+
+  // Fixed steps run back-to-back before we give up on catching up
+  const int maxUpdatesPerPass = 8;
+
+  // Dynamic resolution tuning.  Steps are multiplicative; the gap between the
+  // thresholds is the hysteresis.
+  const float resShrinkAbove = 0.90f;  // Of the frame budget
+  const float resGrowBelow   = 0.60f;
+  const float resShrinkStep  = 0.85f;
+  const float resGrowStep    = 1.05f;
+  const float resSmoothing   = 0.2f;   // Weight of the newest draw time
+  const int   resCooldown    = 15;     // Frames to settle after a change
+
+  // Renderer benchmark, and where its winner is remembered
+  const int   benchFrames      = 30;
+  const int   benchOpsPerFrame = 200;
+  const char* benchCacheFile   = "renderer-driver.txt";
+
+  // Texture rebuilding after a device reset, per window per frame
+  const Uint32 recoveryTicksPerFrame = 4;
+
+  // Input latency bookkeeping, per window
+  const size_t latencyCapacity   = 256;  // Samples kept for percentiles
+  const size_t maxInputsPerFrame = 64;   // Beyond this, one frame's inputs go unsampled
+
+  Uint64 ticksToHRC(Uint32 ticks) {
+    return(Uint64(ticks) * SDL_GetPerformanceFrequency() / 1000);
+  }
+
   void Engine::addJoystick(Uint32 deviceIndex) {
     if(_joysticksEnabled) {
       _joystickData.push_back(sdl_shared(SDL_JoystickOpen(deviceIndex)));
@@ -53,71 +174,200 @@ namespace jdi {
   }
   
   Engine::window_datum_type* Engine::getDataByWindow(window_ptr window) {
-    for(auto& data : _windowData) {
-      if(data.window == window) return (&data);
-    }
-    return(nullptr);
+    auto found = _windowByPtr.find(window.get());
+    return(found == _windowByPtr.end() ? nullptr : &*(found->second));
   }
 
   const Engine::window_datum_type* Engine::getDataByWindow(window_ptr window) const {
-    for(auto& data : _windowData) {
-      if(data.window == window) return (&data);
-    }
-    return(nullptr);
+    auto found = _windowByPtr.find(window.get());
+    return(found == _windowByPtr.end() ? nullptr : &*(found->second));
   }
 
   Engine::window_datum_type* Engine::getDataByWindowID(Uint32 windowID) {
-    for(auto& data : _windowData) {
-      if(SDL_GetWindowID(data.window.get()) == windowID) return(&data);
-    }
-    return(nullptr);
+    auto found = _windowByID.find(windowID);
+    return(found == _windowByID.end() ? nullptr : &*(found->second));
   }
 
   const Engine::window_datum_type* Engine::getDataByWindowID(Uint32 windowID) const {
-    for(auto& data : _windowData) {
-      if(SDL_GetWindowID(data.window.get()) == windowID) return(&data);
-    }
-    return(nullptr);
+    auto found = _windowByID.find(windowID);
+    return(found == _windowByID.end() ? nullptr : &*(found->second));
   }
 
   Engine::window_datum_type* Engine::getDataByWidget(widget_ptr widget) {
-    widget_ptr root = widget->getRoot();
-    for(auto& data : _windowData) {
-      if(data.root == root) return (&data);
-    }
-    return(nullptr);
+    return(widget->_windowID == 0 ? nullptr : getDataByWindowID(widget->_windowID));
   }
 
   const Engine::window_datum_type* Engine::getDataByWidget(widget_ptr widget) const {
-    widget_ptr root = widget->getRoot();
+    return(widget->_windowID == 0 ? nullptr : getDataByWindowID(widget->_windowID));
+  }
+
+  void Engine::bindWidgets(widget_ptr root, Uint32 windowID) {
+    if(root) {
+      for(widget_ptr iter = root->getFirstPreOrderDFS();
+          iter; iter = root->getNextPreOrderDFS(iter)) {
+        iter->_windowID = windowID;
+        iter->_engine = windowID == 0 ? engine_ptr::weak_type() : _self;
+      }
+    }
+  }
+
+  void Engine::invalidateListeners(Uint32 windowID) {
+    auto dataPtr = getDataByWindowID(windowID);
+    if(dataPtr != nullptr) dataPtr->isListenersStale = true;
+  }
+
+  void Engine::invalidateHitIndex(Uint32 windowID) {
+    auto dataPtr = getDataByWindowID(windowID);
+    if(dataPtr != nullptr) dataPtr->hitIndex.clear();  // Rebuilt when next needed
+  }
+
+  void Engine::updateListeners(window_datum_type* dataPtr) {
+    for(auto& listeners : dataPtr->listeners) listeners.clear();
+    dataPtr->shortcuts.clear();
+    dataPtr->simulators.clear();
+    dataPtr->eventMask = 0;
+
+    if(dataPtr->root) {
+      for(widget_ptr iter = dataPtr->root->getFirstPostOrderDFS();
+          iter; iter = dataPtr->root->getNextPostOrderDFS(iter)) {
+        Uint32 mask = iter->getEventMask();
+        dataPtr->eventMask |= mask;
+        for(int index = 0; index < JDI_EVENT_CLASS_COUNT; ++index) {
+          if(mask & (1u << index)) dataPtr->listeners[index].push_back(iter);
+        }
+        if(iter->isShortcutListener()) dataPtr->shortcuts.push_back(iter);
+      }
+
+      // Updates run in pre-order, parents before children
+      for(widget_ptr iter = dataPtr->root->getFirstPreOrderDFS();
+          iter; iter = dataPtr->root->getNextPreOrderDFS(iter)) {
+        if(iter->isSimulating()) dataPtr->simulators.push_back(iter);
+      }
+    }
+    dataPtr->isListenersStale = false;
+  }
+
+  // Between passes, so that the filter is right before we sleep on the queue
+  void Engine::refreshListeners() {
+    Uint32 eventMask = 0;
     for(auto& data : _windowData) {
-      if(data.root == root) return (&data);
+      if(data.isRemoved) continue;
+      if(data.isListenersStale) updateListeners(&data);
+      eventMask |= data.eventMask;
+    }
+
+    if(eventMask != _eventMask) {
+      _eventMask = eventMask;
+      updateEventFilter();
     }
-    return(nullptr);
   }
 
-  void Engine::updateRenderer(Engine::window_datum_type* dataPtr) {
-    SDL_Renderer* renderer = SDL_GetRenderer(dataPtr->window.get());
+  void Engine::updateEventFilter() {
+    event_filter_state_type& state = getEventFilterState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    Uint32 eventMask = 0;
+    for(Engine* engine : state.engines) eventMask |= engine->_eventMask;
+    state.eventMask.store(eventMask, std::memory_order_relaxed);
+  }
+
+  // Runs inside SDL_PushEvent, on whatever thread raised the event.  Only
+  // events nothing else depends on are dropped:  the input snapshot polls
+  // joystick axes and hats, and the engine itself needs the rest.
+  int SDLCALL Engine::filterEvent(void* userdata, SDL_Event* event) {
+    event_filter_state_type& state = getEventFilterState();
 
-    if(!renderer) {
-      renderer = SDL_CreateRenderer(dataPtr->window.get(),
-                                    -1,   // First matching
-                                    0);  // HW Accellerator requested but not required.
+    switch(event->type) {
+    case SDL_DROPFILE:
+    case SDL_DROPTEXT:
+      if((state.eventMask.load(std::memory_order_relaxed) & JDI_EVENTS_DROP) == 0) {
+        SDL_free(event->drop.file);  // Would have been the receiver's to free
+        return(0);
+      }
+      break;
+      
+    case SDL_FINGERDOWN:
+    case SDL_FINGERUP:
+    case SDL_FINGERMOTION:
+    case SDL_DOLLARGESTURE:
+    case SDL_DOLLARRECORD:
+    case SDL_MULTIGESTURE:
+    case SDL_DROPBEGIN:
+    case SDL_DROPCOMPLETE:
+    case SDL_JOYAXISMOTION:
+    case SDL_JOYBALLMOTION:
+    case SDL_JOYHATMOTION:
+    case SDL_CONTROLLERAXISMOTION:
+    case SDL_CONTROLLERTOUCHPADDOWN:
+    case SDL_CONTROLLERTOUCHPADMOTION:
+    case SDL_CONTROLLERTOUCHPADUP:
+    case SDL_CONTROLLERSENSORUPDATE:
+      if((state.eventMask.load(std::memory_order_relaxed) &
+          getEventClass(event->type)) == 0) {
+        return(0);
+      }
+      break;
     }
 
-    if(dataPtr->renderer.get() != renderer) {
-      dataPtr->renderer
-        = sdl_shared(renderer);  // HW Accellerator requested but not required.
+    return(state.previous == nullptr ? 1 : state.previous(state.previousData, event));
+  }
+
+  // Removed windows linger (unindexed) until nobody can be holding a pointer
+  // to their datum.  This is where they finally go away.
+  void Engine::reapWindows() {
+    auto iter = _windowData.begin();
+    while(iter != _windowData.end()) {
+      if(iter->isRemoved) {
+        if(iter->renderThread) {
+          // The renderer dies where it lives, after any frame still queued
+          renderer_ptr renderer = std::move(iter->renderer);
+          iter->renderThread->runAndWait([&renderer]() { renderer.reset(); });
+        }
+        iter = _windowData.erase(iter);
+      } else {
+        ++iter;
+      }
     }
+  }
+
+  // Make sure the window has a renderer.  Widgets only hear about it, and
+  // rebuild their textures, when the renderer is actually a new one.
+  void Engine::updateRenderer(Engine::window_datum_type* dataPtr) {
+    bool isReplaced = false;
+    
+    std::string driver = dataPtr->rendererDriver;
+    if(driver == "auto") driver = getAutoRenderDriver(dataPtr->rendererFlags,
+                                                   dataPtr->renderThread.get());
     
-    safely(SDL_GetRendererOutputSize(dataPtr->renderer.get(),
-                                     &(dataPtr->bbox.w),
-                                     &(dataPtr->bbox.h)));
+    auto update = [dataPtr, &isReplaced, &driver]() {
+      SDL_Renderer* renderer = SDL_GetRenderer(dataPtr->window.get());
+
+      if(!renderer) {
+        int index = findRenderDriver(driver);
+        renderer = SDL_CreateRenderer(dataPtr->window.get(),
+                                      index,  // -1 for first matching
+                                      dataPtr->rendererFlags);
+        if(!renderer && index >= 0) {
+          renderer = SDL_CreateRenderer(dataPtr->window.get(), -1,
+                                        dataPtr->rendererFlags);
+        }
+      }
+
+      if(dataPtr->renderer.get() != renderer) {
+        dataPtr->resTarget.reset();  // Belongs to the old renderer
+        dataPtr->renderer
+          = sdl_shared(renderer);  // HW Accellerator requested but not required.
+        SDL_SetRenderDrawBlendMode(dataPtr->renderer.get(),
+                                   SDL_BLENDMODE_BLEND);
+        isReplaced = true;
+      }
+    };
 
-    SDL_SetRenderDrawBlendMode(dataPtr->renderer.get(),
-                               SDL_BLENDMODE_BLEND);
+    // A pipelined renderer is made and used on its render thread only
+    if(dataPtr->renderThread) dataPtr->renderThread->runAndWait(update);
+    else              update();
     
-    if(dataPtr->root) {
+    if(isReplaced && dataPtr->root) {
       for(widget_ptr iter = dataPtr->root->getFirstPreOrderDFS();
           iter; iter = dataPtr->root->getNextPreOrderDFS(iter)) {
         iter->onRenderUpdate(dataPtr->renderer);
@@ -127,6 +377,458 @@ namespace jdi {
     dataPtr->willResize = true;
     dataPtr->willUpdate = true;
   }
+
+  // Drop the window's renderer, giving widgets a chance to let go of theirs
+  // first.
+  void Engine::releaseRenderer(window_datum_type* dataPtr) {
+    if(!dataPtr->renderer) return;
+    
+    if(dataPtr->root) {
+      for(widget_ptr iter = dataPtr->root->getFirstPreOrderDFS();
+          iter; iter = dataPtr->root->getNextPreOrderDFS(iter)) {
+        iter->onRenderUpdate(nullptr);
+      }
+    }
+
+    auto release = [dataPtr]() {
+      dataPtr->resTarget.reset();
+      dataPtr->renderer.reset();
+    };
+    
+    if(dataPtr->renderThread) dataPtr->renderThread->runAndWait(release);
+    else                      release();
+  }
+
+  int Engine::findRenderDriver(const std::string& name) {
+    if(name.empty()) return(-1);
+    
+    int count = SDL_GetNumRenderDrivers();
+    for(int index = 0; index < count; ++index) {
+      SDL_RendererInfo info;
+      if(SDL_GetRenderDriverInfo(index, &info) == 0 && name == info.name) {
+        return(index);
+      }
+    }
+    return(-1);
+  }
+
+  // Time a short burst of fills, sprite copies and texture uploads on a
+  // hidden window.  Vsync is left off so the driver, not the display, sets
+  // the pace.
+  Uint64 Engine::benchmarkRenderDriver(int index, Uint32 flags) {
+    try {
+      window_ptr window = sdl_shared(SDL_CreateWindow("", SDL_WINDOWPOS_UNDEFINED,
+                                                      SDL_WINDOWPOS_UNDEFINED,
+                                                      256, 256, SDL_WINDOW_HIDDEN));
+      renderer_ptr renderer
+        = sdl_shared(SDL_CreateRenderer(window.get(), index,
+                                        flags & ~SDL_RENDERER_PRESENTVSYNC));
+      surface_ptr surface
+        = sdl_shared(SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32,
+                                                    SDL_PIXELFORMAT_RGBA8888));
+      texture_ptr texture
+        = sdl_shared(SDL_CreateTextureFromSurface(renderer.get(), surface.get()));
+      Uint32 pixel = 0;
+
+      Uint64 startHRC = SDL_GetPerformanceCounter();
+      for(int frame = 0; frame < benchFrames; ++frame) {
+        SDL_UpdateTexture(texture.get(), nullptr, surface->pixels, surface->pitch);
+        for(int op = 0; op < benchOpsPerFrame; ++op) {
+          SDL_Rect rect = {(op * 7) % 192, (op * 13) % 192, 64, 64};
+          SDL_SetRenderDrawColor(renderer.get(), op, frame, 128, 255);
+          SDL_RenderFillRect(renderer.get(), &rect);
+          SDL_RenderCopy(renderer.get(), texture.get(), nullptr, &rect);
+        }
+        // Reading back forces the driver to actually finish the work
+        SDL_Rect one = {0, 0, 1, 1};
+        SDL_RenderReadPixels(renderer.get(), &one, SDL_PIXELFORMAT_RGBA8888,
+                             &pixel, sizeof(pixel));
+        SDL_RenderPresent(renderer.get());
+      }
+      return(std::max<Uint64>(1, SDL_GetPerformanceCounter() - startHRC));
+    }
+    catch(const Error&) {
+      return(0);
+    }
+  }
+
+  // The fastest driver on this machine for a set of renderer flags.
+  // Measured on first use, then read back from the preferences directory on
+  // later starts, one "flags driver" line per set.
+  const std::string& Engine::getAutoRenderDriver(Uint32 flags, RenderThread* thread) {
+    flags &= ~SDL_RENDERER_PRESENTVSYNC;  // The benchmark runs without it
+    auto found = _autoDrivers.find(flags);
+    if(found != _autoDrivers.end()) return(found->second);
+
+    std::filesystem::path cachePath;
+    if(!_prefPath.empty()) {
+      cachePath = _prefPath / benchCacheFile;
+      std::ifstream cache(cachePath);
+      Uint32 cachedFlags;
+      std::string name;
+      while(cache >> cachedFlags >> name) {
+        if(findRenderDriver(name) >= 0) _autoDrivers[cachedFlags] = name;
+      }
+      found = _autoDrivers.find(flags);
+      if(found != _autoDrivers.end()) return(found->second);
+    }
+
+    std::string& driver = _autoDrivers[flags];
+    ++_benchmarkCount;
+
+    auto bench = [flags, &driver]() {
+      Uint64 bestHRC = 0;
+      int count = SDL_GetNumRenderDrivers();
+      for(int index = 0; index < count; ++index) {
+        SDL_RendererInfo info;
+        if(SDL_GetRenderDriverInfo(index, &info) != 0) continue;
+        Uint64 timeHRC = benchmarkRenderDriver(index, flags);
+        if(timeHRC != 0 && (bestHRC == 0 || timeHRC < bestHRC)) {
+          bestHRC = timeHRC;
+          driver = info.name;
+        }
+      }
+    };
+
+    // Renderers belong on the render thread, even throwaway ones
+    if(thread) thread->runAndWait(bench);
+    else              bench();
+
+    if(!driver.empty() && !cachePath.empty()) {
+      std::ofstream cache(cachePath);
+      for(const auto& entry : _autoDrivers) {
+        if(!entry.second.empty()) cache << entry.first << ' ' << entry.second << std::endl;
+      }
+    }
+    return(driver);  // Empty if nothing worked; SDL picks
+  }
+  
+  // Where a pointer event happened, in draw rect coordinates.  False for
+  // anything that isn't a pointer event.
+  bool Engine::getEventPoint(const window_datum_type* dataPtr, const SDL_Event& event,
+                             SDL_Point& point) const {
+    switch(event.type) {
+    case SDL_MOUSEMOTION:
+      point = SDL_Point{event.motion.x, event.motion.y};
+      return(true);
+      
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+      point = SDL_Point{event.button.x, event.button.y};
+      return(true);
+      
+    case SDL_MOUSEWHEEL:
+#if SDL_VERSION_ATLEAST(2, 26, 0)
+      point = SDL_Point{event.wheel.mouseX, event.wheel.mouseY};
+#else
+      SDL_GetMouseState(&point.x, &point.y);  // Older wheel events don't say
+#endif
+      return(true);
+
+    case SDL_FINGERDOWN:
+    case SDL_FINGERUP:
+    case SDL_FINGERMOTION:
+      // Normalized to the window
+      point = SDL_Point{int(event.tfinger.x * dataPtr->bbox.w),
+                        int(event.tfinger.y * dataPtr->bbox.h)};
+      return(true);
+    }
+    
+    return(false);
+  }
+
+  void Engine::updateHover(window_datum_type* dataPtr,
+                           const std::vector<widget_ptr>& hits) {
+    for(auto& weakWidget : dataPtr->hovered) {
+      widget_ptr widget = weakWidget.lock();
+      if(widget && std::find(hits.begin(), hits.end(), widget) == hits.end()) {
+        widget->onMouseLeave(dataPtr->renderer);
+      }
+    }
+    
+    for(auto& widget : hits) {
+      bool wasHovered = false;
+      for(auto& weakWidget : dataPtr->hovered) {
+        if(weakWidget.lock() == widget) { wasHovered = true; break; }
+      }
+      if(!wasHovered) widget->onMouseEnter(dataPtr->renderer);
+    }
+
+    dataPtr->hovered.assign(hits.begin(), hits.end());
+  }
+  
+  // Remember when an input reached a window whose next frame will show it
+  void Engine::markInput(window_datum_type* dataPtr, const SDL_Event& event) {
+    if(event.type < SDL_KEYDOWN || event.type >= SDL_CLIPBOARDUPDATE) return;
+    if(!dataPtr->willUpdate && dataPtr->animTicksPerFrame == 0) return;
+    if(dataPtr->pendingInputs.size() >= maxInputsPerFrame) return;
+
+    // A merged event has been waiting since its oldest sample
+    Uint32 stamp = _coalescedSamples.empty() ? event.common.timestamp
+      : _coalescedSamples.front().common.timestamp;
+    Uint32 now = SDL_GetTicks();
+    Uint32 age = stamp == 0 || stamp > now ? 0 : now - stamp;
+    dataPtr->pendingInputs.push_back(input_mark_type{SDL_GetPerformanceCounter(), age});
+  }
+
+  void Engine::recordLatency(window_datum_type* dataPtr,
+                             const input_mark_seq_type& inputs,
+                             Uint64 doneHRC) {
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    
+    for(auto& input : inputs) {
+      Uint64 usec = Uint64(input.ageTicks) * 1000
+        + (doneHRC - std::min(doneHRC, input.dispatchHRC)) * 1000000 / freq;
+      Uint32 sample = Uint32(std::min<Uint64>(usec, 0xFFFFFFFF));
+      
+      if(dataPtr->latencyUSec.size() < latencyCapacity) {
+        dataPtr->latencyUSec.push_back(sample);
+      } else {
+        dataPtr->latencyUSec[dataPtr->latencyNext] = sample;
+      }
+      dataPtr->latencyNext = (dataPtr->latencyNext + 1) % latencyCapacity;
+    }
+  }
+
+  // How long past its nominal start an animating frame may wait and still
+  // make the next present:  the period, less last frame's draw time and the
+  // safety margin.
+  Uint64 Engine::getLatchDelay(const window_datum_type* dataPtr) const {
+    if(!_isLateLatched || dataPtr->animTicksPerFrame == 0 || dataPtr->refreshHRC == 0) {
+      return(0);
+    }
+
+    Uint64 period = getFramePeriod(dataPtr, dataPtr->animTicksPerFrame);
+    Uint64 drawHRC = dataPtr->intraUpdateHRC
+      - std::min(dataPtr->intraUpdateHRC, dataPtr->presentHRC);
+    Uint64 lead = drawHRC + _latchMarginHRC;
+    return(lead >= period ? 0 : period - lead);
+  }
+
+  // Take in pointer motion that arrived while we waited to draw.  Only the
+  // motion at the head of the queue is taken, up to the first event of any
+  // other kind, so nothing is handled out of order.
+  void Engine::latchPointer() {
+    SDL_PumpEvents();
+
+    SDL_Event events[32];
+    for(;;) {
+      int count = SDL_PeepEvents(events, 32, SDL_PEEKEVENT,
+                                 SDL_FIRSTEVENT, SDL_LASTEVENT);
+      int motions = 0;
+      while(motions < count && (events[motions].type == SDL_MOUSEMOTION ||
+                                events[motions].type == SDL_FINGERMOTION)) {
+        ++motions;
+      }
+      if(motions == 0) break;
+
+      // Only we take from the queue, so its head is still what we saw
+      count = SDL_PeepEvents(events, motions, SDL_GETEVENT,
+                             SDL_FIRSTEVENT, SDL_LASTEVENT);
+      for(int i = 0; i < count; ++i) dispatchEvent(events[i]);
+      if(motions < 32) break;  // Stopped at something else
+    }
+    flushCoalesced();
+  }
+
+  // Edges from events, so taps shorter than a pass are not lost to polling
+  void Engine::recordInputEdge(const SDL_Event& event) {
+    switch(event.type) {
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+      {
+        int key = event.key.keysym.scancode;
+        if(event.key.repeat || key < 0 || key >= SDL_NUM_SCANCODES) break;
+        if(event.type == SDL_KEYDOWN) _inputNext._keysPressed[key] = 1;
+        else                          _inputNext._keysReleased[key] = 1;
+      }
+      break;
+      
+    case SDL_MOUSEBUTTONDOWN:
+      _inputNext._buttonsPressed |= SDL_BUTTON(event.button.button);
+      break;
+      
+    case SDL_MOUSEBUTTONUP:
+      _inputNext._buttonsReleased |= SDL_BUTTON(event.button.button);
+      break;
+      
+    case SDL_MOUSEWHEEL:
+      _inputNext._wheelX += event.wheel.x;
+      _inputNext._wheelY += event.wheel.y;
+      break;
+
+    case SDL_JOYBUTTONDOWN:
+    case SDL_JOYBUTTONUP:
+      _joystickEdges.push_back(joystick_edge_type{event.jbutton.which,
+                                                  event.jbutton.button,
+                                                  event.type == SDL_JOYBUTTONDOWN});
+      break;
+    }
+  }
+
+  // Poll the devices into the next snapshot, add polled edges to the ones
+  // events gave us, and publish it.
+  void Engine::snapshotInput() {
+    InputState& next = _inputNext;
+    const InputState& prev = _input;
+
+    int keyCount = 0;
+    const Uint8* keys = SDL_GetKeyboardState(&keyCount);
+    keyCount = std::min<int>(keyCount, SDL_NUM_SCANCODES);
+    for(int key = 0; key < keyCount; ++key) {
+      Uint8 held = keys[key] ? 1 : 0;
+      next._keys[key] = held;
+      if(held && !prev._keys[key]) next._keysPressed[key] = 1;
+      if(!held && prev._keys[key]) next._keysReleased[key] = 1;
+    }
+    next._modifiers = Uint16(SDL_GetModState());
+
+    next._buttons = SDL_GetMouseState(&next._mouseX, &next._mouseY);
+    next._buttonsPressed |= next._buttons & ~prev._buttons;
+    next._buttonsReleased |= prev._buttons & ~next._buttons;
+    SDL_Window* mouseFocus = SDL_GetMouseFocus();
+    next._mouseWindowID
+      = mouseFocus != nullptr && _windowByPtr.count(mouseFocus) != 0
+      ? SDL_GetWindowID(mouseFocus) : 0;
+
+    next._joysticks.resize(_joystickData.size());
+    for(size_t i = 0; i < _joystickData.size(); ++i) {
+      SDL_Joystick* joystick = _joystickData[i].get();
+      InputState::joystick_state_type& state = next._joysticks[i];
+      
+      state.id = SDL_JoystickInstanceID(joystick);
+      state.axes.resize(std::max(0, SDL_JoystickNumAxes(joystick)));
+      for(size_t axis = 0; axis < state.axes.size(); ++axis) {
+        state.axes[axis] = SDL_JoystickGetAxis(joystick, int(axis));
+      }
+      state.hats.resize(std::max(0, SDL_JoystickNumHats(joystick)));
+      for(size_t hat = 0; hat < state.hats.size(); ++hat) {
+        state.hats[hat] = SDL_JoystickGetHat(joystick, int(hat));
+      }
+
+      const InputState::joystick_state_type* before = prev.getJoystick(state.id);
+      size_t buttonCount = std::max(0, SDL_JoystickNumButtons(joystick));
+      state.buttons.resize(buttonCount);
+      state.pressed.assign(buttonCount, 0);
+      state.released.assign(buttonCount, 0);
+      for(size_t button = 0; button < buttonCount; ++button) {
+        Uint8 held = SDL_JoystickGetButton(joystick, int(button)) ? 1 : 0;
+        bool wasHeld = before != nullptr && InputState::getFlag(before->buttons, int(button));
+        state.buttons[button] = held;
+        if(held && !wasHeld) state.pressed[button] = 1;
+        if(!held && wasHeld) state.released[button] = 1;
+      }
+      
+      for(auto& edge : _joystickEdges) {
+        if(edge.id != state.id || edge.button >= buttonCount) continue;
+        if(edge.isDown) state.pressed[edge.button] = 1;
+        else            state.released[edge.button] = 1;
+      }
+    }
+    _joystickEdges.clear();
+
+    next._serial = prev._serial + 1;
+    std::swap(_input, _inputNext);
+    _inputNext.clearEdges();
+  }
+  
+  void Engine::setLateLatch(bool enable, Uint32 marginUSec) {
+    _isLateLatched = enable;
+    _latchMarginHRC = SDL_GetPerformanceFrequency() * marginUSec / 1000000;
+  }
+
+  Uint64 Engine::getInputLatencyUSec(window_ptr window, float percentile) const {
+    auto dataPtr = getDataByWindow(window);
+    if(dataPtr == nullptr || dataPtr->latencyUSec.empty()) return(0);
+
+    latency_seq_type samples = dataPtr->latencyUSec;
+    float rank = std::min(100.0f, std::max(0.0f, percentile)) / 100.0f;
+    auto nth = samples.begin() + size_t(rank * float(samples.size() - 1) + 0.5f);
+    std::nth_element(samples.begin(), nth, samples.end());
+    return(*nth);
+  }
+
+  size_t Engine::getInputLatencySamples(window_ptr window) const {
+    auto dataPtr = getDataByWindow(window);
+
+    return(dataPtr == nullptr ? 0 : dataPtr->latencyUSec.size());
+  }
+  
+  void Engine::handleRenderReset(bool isDeviceLost) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    
+    for(auto& data : _windowData) {
+      if(data.isRemoved || !data.renderer) continue;
+
+      if(isDeviceLost) {
+        for(auto& sprite : Sprite::getTexturedSprites(data.renderer)) {
+          data.staleSprites.push_back(sprite);
+        }
+        data.resTarget.reset();
+      }
+      // Render targets lose their contents either way; ours is redrawn anyhow
+
+      if(data.root) {
+        for(widget_ptr iter = data.root->getFirstPreOrderDFS();
+            iter; iter = data.root->getNextPreOrderDFS(iter)) {
+          iter->onRenderReset(data.renderer, isDeviceLost);
+        }
+      }
+      
+      data.resetHRC = now;
+      data.willUpdate = true;
+    }
+  }
+
+  // Rebuild lost textures until this frame's share of time is used up.  The
+  // recovery is done when the list runs dry.
+  void Engine::recoverTextures(window_datum_type* dataPtr) {
+    if(dataPtr->resetHRC == 0) return;
+
+    Uint64 startHRC = SDL_GetPerformanceCounter();
+    Uint64 budgetHRC = ticksToHRC(recoveryTicksPerFrame);
+    renderer_ptr renderer = dataPtr->renderer;
+    sprite_seq_type& stale = dataPtr->staleSprites;
+
+    auto rebuild = [&]() {
+      while(!stale.empty()) {
+        sprite_ptr sprite = stale.back().lock();
+        stale.pop_back();
+        if(!sprite || !sprite->hasTextureFrom(renderer)) continue;
+        
+        try {
+          sprite->generateTexture(renderer);
+        }
+        catch(const Error&) {
+          stale.push_back(sprite);  // Device not back yet; next frame
+          break;
+        }
+        if(SDL_GetPerformanceCounter() - startHRC >= budgetHRC) break;
+      }
+    };
+
+    if(dataPtr->renderThread) dataPtr->renderThread->runAndWait(rebuild);
+    else                      rebuild();
+
+    if(stale.empty()) {
+      dataPtr->recoveryHRC = SDL_GetPerformanceCounter() - dataPtr->resetHRC;
+      dataPtr->resetHRC = 0;
+    }
+    dataPtr->willUpdate = true;  // Draw now, and keep frames coming until done
+  }
+  
+  // Read the output size at layout time, so a burst of size changes during a
+  // live resize costs one query and one layout per frame.
+  void Engine::updateOutputSize(window_datum_type* dataPtr) {
+    auto update = [dataPtr]() {
+      safely(SDL_GetRendererOutputSize(dataPtr->renderer.get(),
+                                       &(dataPtr->bbox.w),
+                                       &(dataPtr->bbox.h)));
+    };
+
+    if(dataPtr->renderThread) dataPtr->renderThread->runAndWait(update);
+    else                      update();
+  }
   
   void Engine::setFullscreen(Engine::window_datum_type* dataPtr,
                              bool enabled) {
@@ -143,14 +845,23 @@ namespace jdi {
   }
 
   void Engine::resizeWidgets(window_datum_type* dataPtr) {
-    if(dataPtr->willResize && dataPtr->root && dataPtr->root->isVisible()) {      
+    if(!dataPtr->willResize) return;
+
+    updateOutputSize(dataPtr);
+    if(dataPtr->root && dataPtr->root->isVisible()) {      
       dataPtr->root->setDrawRect(&(dataPtr->bbox));
       dataPtr->root->onResize(dataPtr->renderer);
     }
+    dataPtr->hitIndex.rebuild(dataPtr->root, &(dataPtr->bbox));
     dataPtr->willResize = false;
   }
 
   void Engine::updateWidgets(window_datum_type* dataPtr) {
+    if(dataPtr->present) {
+      recordWidgets(dataPtr);
+      return;
+    }
+    
     if(dataPtr->willUpdate) {
       dataPtr->penultimateUpdateHRC = dataPtr->ultimateUpdateHRC;
       dataPtr->ultimateUpdateHRC = SDL_GetPerformanceCounter();
@@ -160,154 +871,853 @@ namespace jdi {
                              dataPtr->bgColor.g,
                              dataPtr->bgColor.b,
                              dataPtr->bgColor.a);
+      bool isScaled = beginScaledDraw(dataPtr);
       safely(SDL_RenderClear(dataPtr->renderer.get()));            
+      if(_ticksPerUpdate != 0) {
+        Uint64 period = ticksToHRC(_ticksPerUpdate);
+        Uint64 ahead = std::min(period, _nextUpdateHRC - std::min(_nextUpdateHRC,
+                                                                  dataPtr->ultimateUpdateHRC));
+        _updateAlpha = 1.0f - float(ahead) / float(period);
+      }
       if(dataPtr->root && dataPtr->root->isVisible()) {
         dataPtr->root->onDraw(dataPtr->renderer);
       }
+      if(isScaled) endScaledDraw(dataPtr);
+      Uint64 presentHRC = SDL_GetPerformanceCounter();
       SDL_RenderPresent(dataPtr->renderer.get());
-      dataPtr->intraUpdateHRC = SDL_GetPerformanceCounter() - dataPtr->ultimateUpdateHRC;
+      Uint64 doneHRC = SDL_GetPerformanceCounter();
+      dataPtr->presentHRC = doneHRC - presentHRC;
+      dataPtr->intraUpdateHRC = doneHRC - dataPtr->ultimateUpdateHRC;
+      updateResolutionScale(dataPtr, presentHRC - dataPtr->ultimateUpdateHRC);
+      measureRefresh(dataPtr, doneHRC);
+      recordLatency(dataPtr, dataPtr->pendingInputs, doneHRC);
+      dataPtr->pendingInputs.clear();
     }
     dataPtr->willUpdate = false;
   }
   
-  void Engine::startAnimateCallback() {
-    if(_animateTimer == 0 &&
-       _ticksPerFrame != 0) {
-      _animateTimer = SDL_AddTimer(_ticksPerFrame,
-                                   *animateCallback,
-                                   this);
+  // Point the renderer at a reduced offscreen target, if the window is scaled
+  // down.  The render scale maps full-size widget coordinates onto it.
+  bool Engine::beginScaledDraw(window_datum_type* dataPtr) {
+    if(!dataPtr->isDynamicRes || dataPtr->resScale >= 1.0f) return(false);
+
+    SDL_Renderer* renderer = dataPtr->renderer.get();
+    int w = std::max(1, int(dataPtr->bbox.w * dataPtr->resScale + 0.5f));
+    int h = std::max(1, int(dataPtr->bbox.h * dataPtr->resScale + 0.5f));
+
+    int targetW = 0;
+    int targetH = 0;
+    if(dataPtr->resTarget) {
+      SDL_QueryTexture(dataPtr->resTarget.get(), nullptr, nullptr, &targetW, &targetH);
+    }
+    if(targetW != w || targetH != h) {
+      dataPtr->resTarget.reset();
+      SDL_Texture* target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                                              SDL_TEXTUREACCESS_TARGET, w, h);
+      if(target == nullptr) {
+        dataPtr->isDynamicRes = false;  // No render targets here; stay full size
+        dataPtr->resScale = 1.0f;
+        return(false);
+      }
+      dataPtr->resTarget = sdl_shared(target);
+    }
+
+    SDL_SetRenderTarget(renderer, dataPtr->resTarget.get());
+    SDL_RenderSetScale(renderer,
+                       float(w) / float(std::max(1, dataPtr->bbox.w)),
+                       float(h) / float(std::max(1, dataPtr->bbox.h)));
+    return(true);
+  }
+
+  void Engine::endScaledDraw(window_datum_type* dataPtr) {
+    SDL_Renderer* renderer = dataPtr->renderer.get();
+    
+    SDL_SetRenderTarget(renderer, nullptr);
+    SDL_RenderSetScale(renderer, 1.0f, 1.0f);
+    SDL_RenderCopy(renderer, dataPtr->resTarget.get(), nullptr, nullptr);
+  }
+
+  void Engine::updateResolutionScale(window_datum_type* dataPtr, Uint64 drawHRC) {
+    if(!dataPtr->isDynamicRes) return;
+
+    dataPtr->drawAvgHRC = dataPtr->drawAvgHRC == 0.0f ? float(drawHRC)
+      : dataPtr->drawAvgHRC + resSmoothing * (float(drawHRC) - dataPtr->drawAvgHRC);
+    if(dataPtr->resCooldown > 0) {
+      --dataPtr->resCooldown;
+      return;
+    }
+
+    Uint32 ticks
+      = dataPtr->animTicksPerFrame != 0 ? dataPtr->animTicksPerFrame
+      : _ticksPerFrame != 0             ? _ticksPerFrame
+      : defaultTicksPerFrame;
+    float budget = float(getFramePeriod(dataPtr, ticks));
+    float scale = dataPtr->resScale;
+    
+    if(dataPtr->drawAvgHRC > resShrinkAbove * budget) {
+      scale = std::max(dataPtr->resFloor, scale * resShrinkStep);
+    } else if(dataPtr->drawAvgHRC < resGrowBelow * budget) {
+      scale = std::min(1.0f, scale * resGrowStep);
+    }
+
+    if(scale != dataPtr->resScale) {
+      dataPtr->resScale = scale;
+      dataPtr->resCooldown = resCooldown;
+      dataPtr->drawAvgHRC = 0.0f;  // Start over at the new size
+    }
+  }
+  
+  // Pipelined counterpart of updateWidgets():  record now, present on the
+  // render thread.  A window still presenting its last frame keeps its
+  // update pending; the render thread wakes us when it is done.
+  void Engine::recordWidgets(window_datum_type* dataPtr) {
+    present_state_ptr present = dataPtr->present;
+    if(!dataPtr->willUpdate || present->isInFlight.load()) return;
+
+    dataPtr->penultimateUpdateHRC = dataPtr->ultimateUpdateHRC;
+    dataPtr->ultimateUpdateHRC = SDL_GetPerformanceCounter();
+    dataPtr->presentHRC = present->presentHRC.load();
+    dataPtr->intraUpdateHRC = present->intraUpdateHRC.load();
+    
+    if(_ticksPerUpdate != 0) {
+      Uint64 period = ticksToHRC(_ticksPerUpdate);
+      Uint64 ahead = std::min(period, _nextUpdateHRC - std::min(_nextUpdateHRC,
+                                                                dataPtr->ultimateUpdateHRC));
+      _updateAlpha = 1.0f - float(ahead) / float(period);
     }
+
+    auto list = std::make_shared<DrawList>();
+    list->setColor(dataPtr->bgColor);
+    list->clear();
+    if(dataPtr->root && dataPtr->root->isVisible()) {
+      dataPtr->root->onRecord(*list);
+    }
+    list->resolveSprites(dataPtr->renderer, dataPtr->renderThread.get());
+
+    renderer_ptr renderer = dataPtr->renderer;
+    Uint64 startHRC = dataPtr->ultimateUpdateHRC;
+    Uint32 windowID = dataPtr->windowID;
+    input_mark_seq_type inputs;
+    inputs.swap(dataPtr->pendingInputs);
+    present->isInFlight.store(true);
+    auto task = [this, renderer, list, present, startHRC, windowID, inputs]() {
+        list->replay(renderer);
+        Uint64 presentHRC = SDL_GetPerformanceCounter();
+        SDL_RenderPresent(renderer.get());
+        Uint64 doneHRC = SDL_GetPerformanceCounter();
+        present->presentHRC.store(doneHRC - presentHRC);
+        present->intraUpdateHRC.store(doneHRC - startHRC);
+        present->isInFlight.store(false);
+
+        // Also wakes the engine for the next frame
+        post([this, windowID, inputs, doneHRC]() {
+            auto dataPtr = getDataByWindowID(windowID);
+            if(dataPtr != nullptr) {
+              measureRefresh(dataPtr, doneHRC);
+              recordLatency(dataPtr, inputs, doneHRC);
+            }
+          });
+      };
+
+    // A widget drawing straight from its own state has to finish before
+    // the engine thread touches that state again
+    if(list->isSynced()) dataPtr->renderThread->runAndWait(task);
+    else                 dataPtr->renderThread->run(task);
+    dataPtr->willUpdate = false;
   }
   
-  Uint32 Engine::animateCallback(Uint32 interval, void* engine) {
-    // We can't actually draw on this thread.  We'll push a special event onto
-    // the event queue and let the engine handle it when the queue makes it
-    // around.
-    static Uint32 jdiEventType = Engine::getJDIEventType();
+  void Engine::updateAnimation(window_datum_type* dataPtr) {
+    Uint32 fastest = 0;
     
-    SDL_Event event;
-    event.type = jdiEventType;
-    event.user.windowID = 0;
-    event.user.code = JDI_ANIMATE;
-    event.user.data1 = nullptr;
-    event.user.data2 = nullptr;
-    SDL_PushEvent(&event);
+    auto iter = dataPtr->animations.begin();
+    while(iter != dataPtr->animations.end()) {
+      widget_ptr widget = iter->widget.lock();
+      if(!widget || widget->_windowID != dataPtr->windowID) {
+        iter = dataPtr->animations.erase(iter);  // Gone, or moved on
+        continue;
+      }
+
+      Uint32 ticks
+        = iter->ticksPerFrame != 0 ? iter->ticksPerFrame
+        : _ticksPerFrame != 0      ? _ticksPerFrame
+        : defaultTicksPerFrame;
+      if(fastest == 0 || ticks < fastest) fastest = ticks;
+      ++iter;
+    }
+
+    if(fastest == 0) dataPtr->nextFrameHRC = 0;
+    dataPtr->animTicksPerFrame = fastest;
+  }
+
+  void Engine::updateDisplayMode(window_datum_type* dataPtr) {
+    SDL_DisplayMode mode;
     
-    return(static_cast<Engine*>(engine)->_ticksPerFrame);
+    if(SDL_GetWindowDisplayMode(dataPtr->window.get(), &mode) == 0 &&
+       mode.refresh_rate > 0) {
+      Uint64 nominalHRC = SDL_GetPerformanceFrequency() / mode.refresh_rate;
+      if(mode.refresh_rate != dataPtr->refreshRate || dataPtr->refreshHRC == 0) {
+        dataPtr->refreshHRC = nominalHRC;  // Measurements start over
+      }
+      dataPtr->refreshRate = mode.refresh_rate;
+      dataPtr->refreshNominalHRC = nominalHRC;
+    } else {
+      dataPtr->refreshRate = 0;
+      dataPtr->refreshHRC = 0;
+      dataPtr->refreshNominalHRC = 0;
+    }
+    dataPtr->lastPresentHRC = 0;
+  }
+
+  // SDL only reports whole Hz, so a 59.94 Hz display claims 60 and a
+  // schedule built on that drifts against the real vsync.  Presents that
+  // finish one period apart, give or take 2%, were paced by the display
+  // itself; average those in.
+  void Engine::measureRefresh(window_datum_type* dataPtr, Uint64 doneHRC) {
+    Uint64 lastHRC = dataPtr->lastPresentHRC;
+    Uint64 nominalHRC = dataPtr->refreshNominalHRC;
+    dataPtr->lastPresentHRC = doneHRC;
+    if(lastHRC == 0 || nominalHRC == 0 || doneHRC <= lastHRC) return;
+
+    Uint64 intervalHRC = doneHRC - lastHRC;
+    if(intervalHRC * 50 < nominalHRC * 49 || intervalHRC * 50 > nominalHRC * 51) return;
+
+    dataPtr->refreshHRC = (dataPtr->refreshHRC * 15 + intervalHRC) / 16;
+  }
+
+  Uint64 Engine::getFramePeriod(const window_datum_type* dataPtr,
+                                Uint32 ticksPerFrame) const {
+    return(std::max(ticksToHRC(ticksPerFrame), dataPtr->refreshHRC));
+  }
+  
+  Uint64 Engine::getFrameDeadline(window_datum_type* dataPtr) {
+    if(dataPtr->present && dataPtr->present->isInFlight.load()) {
+      return(0);  // Nothing to do until the render thread wakes us
+    }
+    
+    if(dataPtr->animTicksPerFrame != 0) {
+      if(dataPtr->nextFrameHRC == 0) {
+        dataPtr->nextFrameHRC = SDL_GetPerformanceCounter();  // Start right away
+      }
+      return(dataPtr->nextFrameHRC + getLatchDelay(dataPtr));
+    }
+    
+    if(dataPtr->willResize || dataPtr->willUpdate) {
+      // Redraw as soon as the frame rate cap allows
+      return(std::max<Uint64>(1, dataPtr->ultimateUpdateHRC
+                              + getFramePeriod(dataPtr, _ticksPerFrame)));
+    }
+
+    return(0);
+  }
+  
+  Sint32 Engine::getTicksToDeadline() {
+    Sint32 ticks = getTicksToNextDeadline();
+    
+    return(ticks < 0 ? maxHostWaitTicks : std::min(ticks, maxHostWaitTicks));
+  }
+
+  Uint64 Engine::getBusDeadline() const {
+    Uint32 ticks = _ticksPerFrame != 0 ? _ticksPerFrame : defaultTicksPerFrame;
+    return(std::max<Uint64>(1, _busFrameHRC + ticksToHRC(ticks)));
+  }
+
+  Sint32 Engine::getTicksToNextDeadline() {
+    if(_bus.hasQueued(JDI_DELIVER_SAME_FRAME)) return(0);
+    
+    Uint64 deadline = 0;
+    if(_bus.hasQueued(JDI_DELIVER_NEXT_FRAME)) deadline = getBusDeadline();
+    if(_ticksPerUpdate != 0) {
+      if(_nextUpdateHRC == 0) _nextUpdateHRC = SDL_GetPerformanceCounter();
+      if(deadline == 0 || _nextUpdateHRC < deadline) deadline = _nextUpdateHRC;
+    }
+    for(auto& data : _windowData) {
+      if(data.isRemoved) continue;
+      Uint64 windowDeadline = getFrameDeadline(&data);
+      if(windowDeadline != 0 && (deadline == 0 || windowDeadline < deadline)) {
+        deadline = windowDeadline;
+      }
+    }
+    
+    if(deadline == 0) return(-1);  // Idle
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    if(now >= deadline) return(0);
+
+    // Round up so we never spin through the last partial millisecond
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    return(Sint32(std::min<Uint64>(SDL_MAX_SINT32, ((deadline - now) * 1000 + freq - 1) / freq)));
   }
   
-  void Engine::removeAnimateCallback() {
-    if(_animateTimer != 0) {
-      SDL_RemoveTimer(_animateTimer);
-      _animateTimer = 0;
+  bool Engine::waitForEvent(SDL_Event& event, Sint32 timeoutTicks) {
+    Sint32 waitTicks = getTicksToNextDeadline();
+    if(timeoutTicks >= 0 && (waitTicks < 0 || timeoutTicks < waitTicks)) {
+      waitTicks = timeoutTicks;
+    }
+
+    if(_isHeadless) {
+      waitForWake(waitTicks);
+      return(false);
+    }
+    
+    if(waitTicks < 0) {
+      // Idle.  Nothing to do until something happens.
+      if(1 != SDL_WaitEvent(&event)) throw(Error("SDL_WaitEvent"));
+      return(true);
+    } else if(waitTicks == 0) {
+      return(SDL_PollEvent(&event) == 1);
+    } else {
+      return(SDL_WaitEventTimeout(&event, waitTicks) == 1);
+    }
+  }
+
+  void Engine::waitForWake(Sint32 waitTicks) {
+    std::unique_lock<std::mutex> lock(_wakeMutex);
+    auto isWoken = [this]() { return(_isWakePending.load()); };
+    
+    if(waitTicks < 0) {
+      _wakeSignal.wait(lock, isWoken);
+    } else if(waitTicks > 0) {
+      _wakeSignal.wait_for(lock, std::chrono::milliseconds(waitTicks), isWoken);
+    }
+  }
+
+  // True if the window should lay out and draw on this pass.  Advances an
+  // animating window's deadline when it does, folding any whole frames we
+  // overslept into a single late frame.
+  bool Engine::isFrameDue(window_datum_type* dataPtr, Uint64 now) {
+    Uint64 deadline = getFrameDeadline(dataPtr);
+    if(deadline == 0 || now < deadline) return(false);
+
+    dataPtr->lateHRC = now - deadline;
+    if(dataPtr->animTicksPerFrame != 0) {
+      Uint64 period = getFramePeriod(dataPtr, dataPtr->animTicksPerFrame);
+      dataPtr->nextFrameHRC += period;
+      if(now >= dataPtr->nextFrameHRC) {
+        Uint64 missed = (now - dataPtr->nextFrameHRC) / period + 1;
+        _missedFrames += missed;
+        dataPtr->missedFrames += missed;
+        dataPtr->nextFrameHRC += missed * period;
+      }
+      dataPtr->willUpdate = true;
+      updateAnimation(dataPtr);  // Drop demands from widgets that went away
+    }
+    return(true);
+  }
+
+  // Draw every window whose deadline has come, earliest deadline first.  The
+  // clock is re-read after each window, since a present may block on vsync.
+  void Engine::drawDueWindows() {
+    _drawQueue.clear();
+    for(auto& data : _windowData) {
+      if(!data.isRemoved && getFrameDeadline(&data) != 0) {
+        _drawQueue.push_back(&data);
+      }
+    }
+
+    while(!_drawQueue.empty()) {
+      Uint64 now = SDL_GetPerformanceCounter();
+      auto earliest = _drawQueue.end();
+      Uint64 earliestDeadline = 0;
+      
+      for(auto iter = _drawQueue.begin(); iter != _drawQueue.end(); ++iter) {
+        Uint64 deadline = getFrameDeadline(*iter);
+        if(deadline != 0 && deadline <= now &&
+           (earliest == _drawQueue.end() || deadline < earliestDeadline)) {
+          earliest = iter;
+          earliestDeadline = deadline;
+        }
+      }
+      if(earliest == _drawQueue.end()) break;  // Nobody else is due yet
+
+      window_datum_type* dataPtr = *earliest;
+      _drawQueue.erase(earliest);
+      if(dataPtr->isRemoved || !isFrameDue(dataPtr, now)) continue;
+      
+      if(getLatchDelay(dataPtr) != 0) latchPointer();
+      recoverTextures(dataPtr);
+      resizeWidgets(dataPtr);
+      updateWidgets(dataPtr);
+    }
+  }
+
+  void Engine::runUpdates() {
+    if(_ticksPerUpdate == 0) return;
+    
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 period = ticksToHRC(_ticksPerUpdate);
+    if(_nextUpdateHRC == 0) _nextUpdateHRC = now;
+
+    for(int step = 0; now >= _nextUpdateHRC; ++step) {
+      if(step == maxUpdatesPerPass) {
+        Uint64 behind = (now - _nextUpdateHRC) / period + 1;
+        _droppedUpdates += behind;
+        _nextUpdateHRC += behind * period;
+        break;
+      }
+      
+      for(auto& data : _windowData) {
+        if(data.isRemoved || !data.root) continue;
+        if(data.isListenersStale) updateListeners(&data);
+        // By index:  an update may change who simulates, which only marks
+        // the list stale
+        for(size_t index = 0; index < data.simulators.size(); ++index) {
+          widget_ptr widget = data.simulators[index].lock();
+          if(widget && widget->_windowID == data.windowID) widget->onUpdate(_ticksPerUpdate);
+        }
+      }
+      _nextUpdateHRC += period;
+    }
+  }
+
+  void Engine::setFrameRate(Uint32 ticksPerFrame) {
+    _ticksPerFrame = ticksPerFrame;
+    for(auto& data : _windowData) {
+      if(!data.isRemoved) updateAnimation(&data);
+    }
+  }
+
+  bool Engine::requestAnimation(widget_ptr widget,
+                                Uint32 ticksPerFrame) {
+    auto dataPtr = getDataByWidget(widget);
+    if(dataPtr == nullptr) return(false);
+
+    bool isKnown = false;
+    for(auto& anim : dataPtr->animations) {
+      if(anim.widget.lock() == widget) {
+        anim.ticksPerFrame = ticksPerFrame;
+        isKnown = true;
+        break;
+      }
+    }
+    if(!isKnown) {
+      dataPtr->animations.push_back(animation_datum_type{widget, ticksPerFrame});
+    }
+    
+    updateAnimation(dataPtr);
+    return(true);
+  }
+
+  void Engine::cancelAnimation(widget_ptr widget) {
+    auto dataPtr = getDataByWidget(widget);
+    if(dataPtr == nullptr) return;
+
+    for(auto iter = dataPtr->animations.begin();
+        iter != dataPtr->animations.end(); ++iter) {
+      if(iter->widget.lock() == widget) {
+        dataPtr->animations.erase(iter);
+        break;
+      }
     }
+    
+    updateAnimation(dataPtr);
   }
     
 
-  // If the event focuses on a particular window, figure that out and return
-  // the associated datum
-  Engine::window_datum_type* Engine::getEventFocus(const SDL_Event& event) {
+  Uint32 Engine::getEventWindowID(const SDL_Event& event) {
     switch(event.type) {
     case SDL_WINDOWEVENT:
-      return(getDataByWindowID(event.window.windowID));
+      return(event.window.windowID);
     case SDL_KEYDOWN:
     case SDL_KEYUP:
-      return(getDataByWindowID(event.key.windowID));
+      return(event.key.windowID);
     case SDL_TEXTEDITING:
-      return(getDataByWindowID(event.edit.windowID));
+      return(event.edit.windowID);
     case SDL_TEXTEDITING_EXT:
-      return(getDataByWindowID(event.editExt.windowID));
+      return(event.editExt.windowID);
     case SDL_TEXTINPUT:
-      return(getDataByWindowID(event.text.windowID));
+      return(event.text.windowID);
     case SDL_MOUSEMOTION:
-      return(getDataByWindowID(event.motion.windowID));
+      return(event.motion.windowID);
     case SDL_MOUSEBUTTONDOWN:
     case SDL_MOUSEBUTTONUP:
-      return(getDataByWindowID(event.button.windowID));
+      return(event.button.windowID);
     case SDL_MOUSEWHEEL:
-      return(getDataByWindowID(event.wheel.windowID));
+      return(event.wheel.windowID);
     case SDL_FINGERMOTION:
     case SDL_FINGERDOWN:
     case SDL_FINGERUP:
-      return(getDataByWindowID(event.tfinger.windowID));
+      return(event.tfinger.windowID);
     case SDL_DROPBEGIN:
     case SDL_DROPFILE:
     case SDL_DROPTEXT:
     case SDL_DROPCOMPLETE:
-      return(getDataByWindowID(event.drop.windowID));
+      return(event.drop.windowID);
     default:
-      return(event.type < SDL_USEREVENT ? nullptr : getDataByWindowID(event.user.windowID));
+      return(event.type < SDL_USEREVENT ? 0 : event.user.windowID);
+    }
+  }
+
+
+  Uint32 Engine::getEventClass(Uint32 eventType) {
+    switch(eventType) {
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+    case SDL_KEYMAPCHANGED:
+      return(JDI_EVENTS_KEY);
+    case SDL_TEXTEDITING:
+    case SDL_TEXTEDITING_EXT:
+    case SDL_TEXTINPUT:
+      return(JDI_EVENTS_TEXT);
+    case SDL_WINDOWEVENT:
+    case SDL_SYSWMEVENT:
+      return(JDI_EVENTS_WINDOW);
+    }
+
+    // The rest come in blocks
+    if(eventType >= SDL_MOUSEMOTION && eventType < SDL_JOYAXISMOTION) {
+      return(JDI_EVENTS_MOUSE);
+    } else if(eventType >= SDL_JOYAXISMOTION && eventType < SDL_FINGERDOWN) {
+      return(JDI_EVENTS_JOYSTICK);  // Game controllers too
+    } else if(eventType >= SDL_FINGERDOWN && eventType < SDL_CLIPBOARDUPDATE) {
+      return(JDI_EVENTS_TOUCH);     // Gestures too
+    } else if(eventType >= SDL_DROPFILE && eventType < SDL_AUDIODEVICEADDED) {
+      return(JDI_EVENTS_DROP);
+    }
+    return(JDI_EVENTS_OTHER);
+  }
+
+  // Keyboard and text follow the focus path, DOM style:  captured from the
+  // root down to the focused widget's parent, then handled by the focused
+  // widget and bubbled back up to the root.  Whatever is left goes to the
+  // shortcut listeners rather than the whole tree.
+  bool Engine::sendFocusedEvent(window_datum_type* dataPtr, widget_ptr focus,
+                                SDL_Event* eventPtr, Uint32 eventClass) {
+    std::vector<widget_ptr> path;  // Target first
+    for(widget_ptr iter = focus ? focus : dataPtr->root; iter; iter = iter->getParent()) {
+      path.push_back(iter);
+    }
+
+    for(size_t index = path.size(); index-- > 1; ) {
+      if(isListening(path[index], eventClass) &&
+         path[index]->onCaptureEvent(dataPtr->renderer, eventPtr)) {
+        return(true);
+      }
+    }
+
+    for(auto& widget : path) {
+      if(isListening(widget, eventClass) &&
+         widget->onEvent(dataPtr->renderer, eventPtr)) {
+        return(true);
+      }
+    }
+
+    const widget_seq_type& shortcuts = dataPtr->shortcuts;
+    for(size_t index = 0; index < shortcuts.size(); ++index) {
+      widget_ptr widget = shortcuts[index].lock();
+      if(!widget || widget->_windowID != dataPtr->windowID) continue;
+      if(std::find(path.begin(), path.end(), widget) != path.end()) continue;  // Had it
+      if(isListening(widget, eventClass) &&
+         widget->onEvent(dataPtr->renderer, eventPtr)) {
+        return(true);
+      }
+    }
+
+    return(false);
+  }
+
+  bool Engine::sendEvent(Engine::window_datum_type* dataPtr,
+                         SDL_Event* eventPtr) {
+    bool isHalted = false;    
+    if(dataPtr->root) {      
+      widget_ptr focus = dataPtr->focus.lock();
+      Uint32 eventClass = getEventClass(eventPtr->type);
+
+      if(dataPtr->isListenersStale) updateListeners(dataPtr);
+
+      if(eventClass & (JDI_EVENTS_KEY | JDI_EVENTS_TEXT)) {
+        isHalted = sendFocusedEvent(dataPtr, focus, eventPtr, eventClass);
+      } else {
+        // Handle focus tree first
+        if(focus != nullptr) {
+          for(widget_ptr iter = focus->getFirstPostOrderDFS();
+              isHalted == false && iter; iter = focus->getNextPostOrderDFS(iter)) {
+            if(isListening(iter, eventClass)) {
+              isHalted = iter->onEvent(dataPtr->renderer,
+                                       eventPtr);
+            }
+          }
+        }
+
+        SDL_Point point;
+        if(getEventPoint(dataPtr, *eventPtr, point)) {
+          // Pointer events go to what is under the pointer and its ancestors,
+          // topmost first
+          if(!dataPtr->hitIndex.isBuilt()) {
+            dataPtr->hitIndex.rebuild(dataPtr->root, &(dataPtr->bbox));
+          }
+          std::vector<widget_ptr> hits;
+          dataPtr->hitIndex.hitTest(&point, hits);
+          if(eventPtr->type == SDL_MOUSEMOTION) updateHover(dataPtr, hits);
+
+          for(auto& widget : hits) {
+            if(isHalted) break;
+            if(focus && isWithin(widget, focus)) continue;  // Already had it
+            if(isListening(widget, eventClass)) {
+              isHalted = widget->onEvent(dataPtr->renderer,
+                                         eventPtr);
+            }
+          }
+        } else {
+          // Subscribers in the remaining tree, focus pruned.  Handlers may
+          // change masks or trees; that only marks the lists stale.
+          const widget_seq_type& listeners
+            = dataPtr->listeners[getEventClassIndex(eventClass)];
+          for(size_t index = 0; isHalted == false && index < listeners.size(); ++index) {
+            widget_ptr widget = listeners[index].lock();
+            if(!widget || widget->_windowID != dataPtr->windowID) continue;
+            if(focus && isWithin(widget, focus)) continue;
+            if(isListening(widget, eventClass)) {
+              isHalted = widget->onEvent(dataPtr->renderer,
+                                         eventPtr);
+            }
+          }
+        }
+      }
+    }
+
+    markInput(dataPtr, *eventPtr);
+    return(isHalted);
+  }
+  
+  
+  Engine::Engine(const EngineConfig& config) :
+    _isDispatching(false),
+    _joysticksEnabled(false),
+    _liveResizeEnabled(false),
+    _isInLiveResize(false),
+    _ticksPerFrame(0),
+    _missedFrames(0),
+    _isLateLatched(false),
+    _latchMarginHRC(0),
+    _ticksPerUpdate(0),
+    _nextUpdateHRC(0),
+    _droppedUpdates(0),
+    _updateAlpha(1.0f),
+    _maxEventsPerFrame(256),
+    _maxEventTicksPerFrame(0),
+    _rendererDriver(config.rendererDriver),
+    _rendererFlags(config.rendererFlags),
+    _benchmarkCount(0),
+    _coalescing(),
+    _isCoalescing(true),
+    _willExit(false),
+    _eventMask(0),
+    _isWakePending(false),
+    _threadID(SDL_ThreadID()),
+    _isPipelined(config.pipelined),
+    _isHeadless(config.headless),
+    _busFrameHRC(0),
+    _jobThreads(config.jobThreads)
+  {
+    subsystem_state_type& state = getSubsystemState();
+    {
+      std::lock_guard<std::mutex> lock(state.mutex);
+      
+      if(state.engineCount == 0) state.config = config;
+      state.configs.emplace_back(this, config);
+      mergeModes(state);
+      ++state.engineCount;
+    }
+    
+    try {
+      for(int subsystem = 0; subsystem < JDI_SUBSYSTEM_COUNT; ++subsystem) {
+        // Video and controllers drag in SDL's event queue
+        if(_isHeadless && (subsystem == JDI_SUBSYSTEM_VIDEO ||
+                           subsystem == JDI_SUBSYSTEM_CONTROLLER)) {
+          continue;
+        }
+        if(config.getMode(subsystem_type(subsystem)) == JDI_SUBSYSTEM_ON) {
+          requireSubsystem(subsystem_type(subsystem));
+        }
+      }
+    }
+    catch(...) {
+      std::lock_guard<std::mutex> lock(state.mutex);
+      forgetConfig(state, this);
+      --state.engineCount;
+      throw;
+    }
+
+    _jdiEventType = SDL_RegisterEvents(1);
+    if(_isHeadless) return;  // Nothing of ours ever enters the queue
+
+    event_filter_state_type& filterState = getEventFilterState();
+    std::lock_guard<std::mutex> lock(filterState.mutex);
+    if(filterState.engines.empty()) {
+      if(!SDL_GetEventFilter(&filterState.previous, &filterState.previousData)) {
+        filterState.previous = nullptr;
+        filterState.previousData = nullptr;
+      }
+      filterState.eventMask.store(0, std::memory_order_relaxed);
+      SDL_SetEventFilter(filterEvent, nullptr);
+    }
+    filterState.engines.push_back(this);
+  }
+
+  Engine::~Engine() {
+    enableLiveResize(false);
+    _jobs.reset();        // Join workers before anything they could post to goes
+    for(auto& data : _windowData) {
+      if(!data.renderThread) continue;
+      data.renderThread->runAndWait([&data]() { data.renderer.reset(); });
+    }
+    _windowByID.clear();
+    _windowByPtr.clear();
+    _windowData.clear();  // Clear window data _before_ shutting down SDL
+    _joystickData.clear();
+
+    if(!_isHeadless) {
+      event_filter_state_type& filterState = getEventFilterState();
+      std::lock_guard<std::mutex> lock(filterState.mutex);
+      auto& engines = filterState.engines;
+      engines.erase(std::remove(engines.begin(), engines.end(), this), engines.end());
+      for(auto iter = filterState.windowOwners.begin();
+          iter != filterState.windowOwners.end(); ) {
+        if(iter->second == this) iter = filterState.windowOwners.erase(iter);
+        else                     ++iter;
+      }
+      if(engines.empty()) {
+        // Pass everything from now on, in case a later filter chains to us
+        filterState.eventMask.store(~Uint32(0), std::memory_order_relaxed);
+
+        // Setting a filter flushes SDL's queue, and a filter installed after
+        // ours is the program's to keep
+        SDL_EventFilter current;
+        void* currentData;
+        if(SDL_GetEventFilter(&current, &currentData) && current == filterEvent) {
+          SDL_SetEventFilter(filterState.previous, filterState.previousData);
+        }
+      } else {
+        Uint32 eventMask = 0;
+        for(Engine* engine : engines) eventMask |= engine->_eventMask;
+        filterState.eventMask.store(eventMask, std::memory_order_relaxed);
+      }
+    }
+
+    // The last engine out turns off the lights
+    subsystem_state_type& state = getSubsystemState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    forgetConfig(state, this);  // What only we allowed can't start lazily now
+    if(--state.engineCount > 0) return;
+    
+    if(state.isReady[JDI_SUBSYSTEM_AUDIO]) {
+      Mix_CloseAudio();
+      Mix_Quit();
+    }
+    if(state.isReady[JDI_SUBSYSTEM_TTF])   TTF_Quit();
+    if(state.isReady[JDI_SUBSYSTEM_IMAGE]) IMG_Quit();
+    SDL_Quit();
+    
+    for(int subsystem = 0; subsystem < JDI_SUBSYSTEM_COUNT; ++subsystem) {
+      state.isReady[subsystem] = false;
     }
   }
 
+  bool Engine::requireSubsystem(subsystem_type subsystem) {
+    subsystem_state_type& state = getSubsystemState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    
+    if(subsystem < 0 || subsystem >= JDI_SUBSYSTEM_COUNT) return(false);
+    if(state.isReady[subsystem]) return(true);
+    if(state.engineCount == 0 || state.mode[subsystem] == JDI_SUBSYSTEM_OFF) return(false);
 
-  bool Engine::sendEvent(Engine::window_datum_type* dataPtr,
-                         SDL_Event* eventPtr) {
-    bool isHalted = false;    
-    if(dataPtr->root) {      
-      widget_ptr focus = dataPtr->focus.lock();
-      
-      // Handle focus tree first
-      if(focus != nullptr) {
-        for(widget_ptr iter = focus->getFirstPostOrderDFS();
-            isHalted == false && iter; iter = focus->getNextPostOrderDFS(iter)) {
-          if(iter->isEnabled()) {
-            isHalted = iter->onEvent(dataPtr->renderer,
-                                     eventPtr);
-          }
-        }
+    Uint64 startHRC = SDL_GetPerformanceCounter();
+    switch(subsystem) {
+    case JDI_SUBSYSTEM_VIDEO:
+      safely(SDL_Init(SDL_INIT_VIDEO|SDL_INIT_EVENTS));
+      break;
+
+    case JDI_SUBSYSTEM_CONTROLLER:
+      safely(SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER));
+      break;
+
+    case JDI_SUBSYSTEM_IMAGE:
+      if(IMG_Init(state.config.imageFlags) != state.config.imageFlags) {
+        throw(std::runtime_error("Cannot initialize the image libraries!"));
       }
+      break;
 
-      // Handle remaining tree with focus pruned
-      for(widget_ptr iter = dataPtr->root->getFirstPostOrderDFS(focus);
-          isHalted == false && iter; iter = dataPtr->root->getNextPostOrderDFS(iter, focus)) {
-        if(iter->isEnabled()) {
-          isHalted = iter->onEvent(dataPtr->renderer,
-                                   eventPtr);
-        }
+    case JDI_SUBSYSTEM_TTF:
+      safely(TTF_Init());
+      break;
+
+    case JDI_SUBSYSTEM_AUDIO:
+      if(Mix_Init(state.config.mixerFlags) != state.config.mixerFlags) {
+        throw(std::runtime_error("Cannot initialize sound with the requested codecs!"));
       }
+      safely(Mix_OpenAudio(state.config.audioFrequency,
+                           state.config.audioFormat,
+                           state.config.audioChannels,
+                           state.config.audioChunkSize));
+      break;
+
+    default:
+      return(false);
     }
+    
+    state.initHRC[subsystem] = SDL_GetPerformanceCounter() - startHRC;
+    state.isReady[subsystem] = true;
+    return(true);
+  }
 
-    return(isHalted);
+  bool Engine::isSubsystemReady(subsystem_type subsystem) {
+    subsystem_state_type& state = getSubsystemState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    
+    return(subsystem >= 0 && subsystem < JDI_SUBSYSTEM_COUNT &&
+           state.isReady[subsystem]);
   }
-  
-  
-  Engine::Engine() :
-    _joysticksEnabled(false)
-  {    
-    if(getSingletonEngine().lock()) {
-      throw(std::logic_error("Cannot have multiple simultaneous JDI Engines!"));
-    }
 
-    safely(SDL_Init(SDL_INIT_VIDEO|SDL_INIT_EVENTS|SDL_INIT_GAMECONTROLLER));
-    if(IMG_Init(IMG_INIT_PNG) != IMG_INIT_PNG) throw(std::runtime_error("Cannot initialize the image libraries!"));
-    safely(TTF_Init());
+  Uint64 Engine::getSubsystemInitUSec(subsystem_type subsystem) {
+    if(!isSubsystemReady(subsystem)) return(0);
+    return(getSubsystemState().initHRC[subsystem] * 1000000 / SDL_GetPerformanceFrequency());
+  }
 
-    if(Mix_Init(MIX_INIT_OGG) != MIX_INIT_OGG) throw(std::runtime_error("Cannot initialize sound with Ogg Support!"));
+  font_ptr Engine::loadFont(const char* file, int ptSize, long index) {
+    if(!requireSubsystem(JDI_SUBSYSTEM_TTF)) {
+      throw(std::logic_error("Fonts are disabled by the engine configuration!"));
+    }
+    return(sdl_shared(TTF_OpenFontIndex(file, ptSize, index)));
+  }
 
-    safely(Mix_OpenAudio(48000, AUDIO_F32SYS, 2, 1024));
+  chunk_ptr Engine::loadChunk(const char* file) {
+    if(!requireSubsystem(JDI_SUBSYSTEM_AUDIO)) {
+      throw(std::logic_error("Audio is disabled by the engine configuration!"));
+    }
+    return(sdl_shared(Mix_LoadWAV(file)));
   }
 
-  Engine::~Engine() {
-    removeAnimateCallback();  // No reason to animate anything now, is there?
-    _windowData.clear();  // Clear window data _before_ shutting down SDL
-    Mix_CloseAudio();
-    Mix_Quit();
-    TTF_Quit();
-    IMG_Quit();
-    SDL_Quit();
+  music_ptr Engine::loadMusic(const char* file) {
+    if(!requireSubsystem(JDI_SUBSYSTEM_AUDIO)) {
+      throw(std::logic_error("Audio is disabled by the engine configuration!"));
+    }
+    return(sdl_shared(Mix_LoadMUS(file)));
+  }
+  
+  engine_ptr Engine::create(const EngineConfig& config) {
+    engine_ptr reply = engine_ptr(new Engine(config));
+    reply->_self = reply;
+    
+    return(reply);
   }
   
-  engine_ptr Engine::getEngine() {
+  engine_ptr Engine::getEngine(const EngineConfig& config) {
+    static std::mutex singletonMutex;
+    std::lock_guard<std::mutex> lock(singletonMutex);
+    
     engine_ptr reply = getSingletonEngine().lock();
     if(!reply) {
-      reply = engine_ptr(new Engine());
+      reply = create(config);
       getSingletonEngine() = reply;
     }
     return(reply);
   }
 
   void Engine::enableJoysticks(bool enable) {
+    if(enable && !requireSubsystem(JDI_SUBSYSTEM_CONTROLLER)) {
+      return;  // Turned off by the engine configuration
+    }
+    
     if(!enable) {
       _joystickData.clear();      
     } else if(_joystickData.empty()) {
@@ -320,16 +1730,69 @@ namespace jdi {
 
     _joysticksEnabled = enable;
   }
+
+  void Engine::enableLiveResize(bool enable) {
+    if(enable == _liveResizeEnabled) return;
+
+    if(enable) SDL_AddEventWatch(watchLiveResize, this);
+    else       SDL_DelEventWatch(watchLiveResize, this);
+    _liveResizeEnabled = enable;
+  }
+
+  // Runs inside SDL_PushEvent, wherever that was called from.  During a
+  // modal resize that is the window manager's loop on our own thread, with
+  // the engine stuck somewhere in waitForEvent().
+  int SDLCALL Engine::watchLiveResize(void* userdata, SDL_Event* event) {
+    Engine* engine = static_cast<Engine*>(userdata);
+    
+    if(event->type != SDL_WINDOWEVENT ||
+       event->window.event != SDL_WINDOWEVENT_SIZE_CHANGED ||
+       engine->_isDispatching || engine->_isInLiveResize ||
+       !engine->isEngineThread()) {
+      return(1);
+    }
+
+    auto dataPtr = engine->getDataByWindowID(event->window.windowID);
+    if(dataPtr == nullptr) return(1);
+
+    dataPtr->willResize = true;
+    dataPtr->willUpdate = true;
+
+    // Throttled like any other frame.  The event still goes through the
+    // queue afterwards, and the flags it sets are paced as usual.
+    if(engine->isFrameDue(dataPtr, SDL_GetPerformanceCounter())) {
+      engine->_isInLiveResize = true;
+      engine->_isDispatching = true;
+      try {
+        engine->resizeWidgets(dataPtr);
+        engine->updateWidgets(dataPtr);
+      }
+      catch(...) {
+        // Nowhere to throw from inside SDL.  The next frame will retry.
+      }
+      engine->_isDispatching = false;
+      engine->_isInLiveResize = false;
+    }
+    
+    return(1);
+  }
+  
+  window_ptr Engine::getFirstWindow() const {
+    for(auto& data : _windowData) {
+      if(!data.isRemoved) return(data.window);
+    }
+    return(window_ptr());
+  }
   
   window_ptr Engine::getNextWindow(window_ptr window) const {
     if(!window) return(getFirstWindow());
-    
-    for(auto iter = _windowData.begin();
+
+    auto found = _windowByPtr.find(window.get());
+    if(found == _windowByPtr.end()) return(window_ptr());
+
+    for(auto iter = std::next(found->second);
         iter != _windowData.end(); ++iter) {
-      if(iter->window == window) {
-        ++iter;
-        return(iter == _windowData.end() ? window_ptr() : iter->window);
-      }
+      if(!iter->isRemoved) return(iter->window);
     }
     return(window_ptr());
   }
@@ -337,31 +1800,85 @@ namespace jdi {
   window_ptr Engine::createWindow(const char* title,
                                   int x, int y, int w, int h,
                                   Uint32 flags) {
+    if(_isHeadless) throw(std::logic_error("Headless engines can't open windows!"));
+    
     window_ptr window
       = sdl_shared(SDL_CreateWindow(title, x, y, w, h, flags));
 
-    _windowData.push_back(window_datum_type{window});
+    _windowData.push_back(window_datum_type{window,
+                                            SDL_GetWindowID(window.get())});
+
+    auto iter = std::prev(_windowData.end());
+    _windowByID[iter->windowID] = iter;
+    _windowByPtr[window.get()] = iter;
+    {
+      event_filter_state_type& filterState = getEventFilterState();
+      std::lock_guard<std::mutex> lock(filterState.mutex);
+      filterState.windowOwners[iter->windowID] = this;
+    }
 
-    window_datum_type* dataPtr = &(_windowData.back());
+    window_datum_type* dataPtr = &*iter;
 
+    if(_isPipelined) {
+      dataPtr->present = std::make_shared<present_state_type>();
+      dataPtr->renderThread = std::make_shared<RenderThread>();
+    }
+    dataPtr->resScale = 1.0f;
+    dataPtr->resFloor = 1.0f;
+    dataPtr->rendererDriver = _rendererDriver;
+    dataPtr->rendererFlags = _rendererFlags;
     dataPtr->bbox.x = 0;
     dataPtr->bbox.y = 0;
     dataPtr->bgColor.set(255, 0, 255);
 
+    updateDisplayMode(dataPtr);
     updateRenderer(dataPtr);
     
     return(window);
   }
 
   void Engine::removeWindow(window_ptr window) {
-    for(auto iter = _windowData.begin(); iter != _windowData.end(); ++iter) {
-      if(iter->window == window) {
-        _windowData.erase(iter);
-        break;
-      }
+    auto found = _windowByPtr.find(window.get());
+    if(found == _windowByPtr.end()) return;
+
+    auto iter = found->second;
+    _windowByPtr.erase(found);
+    _windowByID.erase(iter->windowID);
+    {
+      event_filter_state_type& filterState = getEventFilterState();
+      std::lock_guard<std::mutex> lock(filterState.mutex);
+      filterState.windowOwners.erase(iter->windowID);
     }
+    iter->isRemoved = true;
+    bindWidgets(iter->root, 0);
+
+    // Mid-dispatch, someone up the stack may still hold this datum.  The main
+    // loop will reap it once the dispatch unwinds.
+    if(!_isDispatching) reapWindows();
+  }
+
+  void Engine::setWindowRenderer(window_ptr window, const std::string& driver,
+                                 Uint32 flags) {
+    auto dataPtr = getDataByWindow(window);
+    if(dataPtr == nullptr) return;
+
+    dataPtr->rendererDriver = driver;
+    dataPtr->rendererFlags = flags;
+    releaseRenderer(dataPtr);
+    updateRenderer(dataPtr);
   }
 
+  std::string Engine::getRendererName(window_ptr window) const {
+    auto dataPtr = getDataByWindow(window);
+    SDL_RendererInfo info;
+    
+    if(dataPtr == nullptr || !dataPtr->renderer ||
+       SDL_GetRendererInfo(dataPtr->renderer.get(), &info) != 0) {
+      return("");
+    }
+    return(info.name);
+  }
+  
   const Color& Engine::getWindowBGColor(window_ptr window) const {
     static Color black(0, 0, 0);
 
@@ -386,17 +1903,27 @@ namespace jdi {
         }
         dataPtr->focus.reset();
         dataPtr->root.reset();        
+        dataPtr->isListenersStale = true;
       }
     }
     
     auto dataPtr = getDataByWindow(window);
 
     if(dataPtr != nullptr) {
+      if(dataPtr->root != widget) {
+        bindWidgets(dataPtr->root, 0);
+        dataPtr->focus.reset();
+        dataPtr->hovered.clear();
+      }
       dataPtr->root = widget;
+      dataPtr->hitIndex.clear();  // Rebuilt when next needed
+      dataPtr->isListenersStale = true;
 
       if(widget) {
         for(widget_ptr child = widget->getFirstPreOrderDFS();
             child; child = widget->getNextPreOrderDFS(child)) {
+          child->_windowID = dataPtr->windowID;
+          child->_engine = _self;
           child->onRenderUpdate(dataPtr->renderer);
         }
       }
@@ -433,8 +1960,13 @@ namespace jdi {
   }
 
   void Engine::requestResizeAll() {
+    if(!isEngineThread()) {
+      postRequest(post_datum_type{JDI_POST_RESIZE_ALL});
+      return;
+    }
+    
     for(auto& data : _windowData) {
-      data.willResize = true;
+      if(!data.isRemoved) data.willResize = true;
     }
   }
 
@@ -451,121 +1983,466 @@ namespace jdi {
     return(dataPtr == nullptr ? -1
            : dataPtr->intraUpdateHRC * 1000000 / SDL_GetPerformanceFrequency());
   }
+
+  Uint64 Engine::getFrameLateUSec(window_ptr window) const {
+    auto dataPtr = getDataByWindow(window);
+
+    return(dataPtr == nullptr ? 0
+           : dataPtr->lateHRC * 1000000 / SDL_GetPerformanceFrequency());
+  }
+
+  void Engine::setDynamicResolution(window_ptr window, bool enable, float floor) {
+    auto dataPtr = getDataByWindow(window);
+    if(dataPtr == nullptr) return;
+
+    dataPtr->isDynamicRes = enable;
+    dataPtr->resFloor = std::min(1.0f, std::max(0.1f, floor));
+    dataPtr->resScale = 1.0f;
+    dataPtr->drawAvgHRC = 0.0f;
+    dataPtr->resCooldown = 0;
+    dataPtr->resTarget.reset();
+    dataPtr->willUpdate = true;
+  }
+
+  float Engine::getResolutionScale(window_ptr window) const {
+    auto dataPtr = getDataByWindow(window);
+
+    return(dataPtr == nullptr ? 1.0f : dataPtr->resScale);
+  }
   
-  void Engine::requestUpdateAll() {
-    for(auto& data : _windowData) {
-      data.willUpdate = true;
-    }
+  bool Engine::isRecovering(window_ptr window) const {
+    auto dataPtr = getDataByWindow(window);
+
+    return(dataPtr != nullptr && dataPtr->resetHRC != 0);
   }
   
-  Uint32 Engine::getJDIEventType() {
-    static Uint32 _jdiEventType = SDL_RegisterEvents(1);
+  Uint64 Engine::getRecoveryTimeUSec(window_ptr window) const {
+    auto dataPtr = getDataByWindow(window);
 
-    return(_jdiEventType);
+    return(dataPtr == nullptr ? 0
+           : dataPtr->recoveryHRC * 1000000 / SDL_GetPerformanceFrequency());
   }
   
-  void Engine::mainLoop() {
-    const Uint32 jdiEventType = getJDIEventType();
-    
-    _willExit = false;
+  Uint64 Engine::getPresentTimeUSec(window_ptr window) const {
+    auto dataPtr = getDataByWindow(window);
+
+    return(dataPtr == nullptr ? 0
+           : dataPtr->presentHRC * 1000000 / SDL_GetPerformanceFrequency());
+  }
+  
+  void Engine::requestUpdateAll() {
+    if(!isEngineThread()) {
+      postRequest(post_datum_type{JDI_POST_UPDATE_ALL});
+      return;
+    }
     
-    while(!_willExit) {
+    for(auto& data : _windowData) {
+      if(!data.isRemoved) data.willUpdate = true;
+    }
+  }
+
+  void Engine::postRequest(post_datum_type&& request) {
+    _posted.push(std::move(request));
+    sendWake();
+  }
+
+  // Only the first request of a batch needs to wake the loop
+  void Engine::sendWake() {
+    if(!_isWakePending.exchange(true)) {
+      if(_isHeadless) {
+        std::lock_guard<std::mutex> lock(_wakeMutex);  // Not between its check and wait
+        _wakeSignal.notify_one();
+        return;
+      }
+      
       SDL_Event event;
+      SDL_memset(&event, 0, sizeof(event));
+      event.type = _jdiEventType;
+      event.user.code = JDI_WAKE;
+      SDL_PushEvent(&event);
+    }
+  }
 
-      startAnimateCallback();
-      if(1 != SDL_WaitEvent(&event)) throw(Error("SDL_WaitEvent"));
+  JobPool& Engine::getJobPool() {
+    std::call_once(_jobsOnce, [this]{ _jobs.reset(new JobPool(_jobThreads)); });
+    return(*_jobs);
+  }
 
-      switch(event.type) {
-        
-      case SDL_QUIT:
-        _willExit = true;
+  void Engine::runPosted() {
+    // Clear first:  anything posted from here on needs a fresh wake-up
+    _isWakePending.store(false);
+
+    post_datum_type request;
+    while(_posted.pop(request)) {
+      switch(request.kind) {
+      case JDI_POST_CALL:
+        try {
+          if(request.call) request.call();
+        }
+        catch(...) {
+          // The rest of the batch waits for the next pass; make sure there is one
+          sendWake();
+          throw;
+        }
         break;
-        
-      case SDL_KEYUP:
-        if(event.key.keysym.sym == SDLK_F11) {
-          auto dataPtr = getDataByWindowID(event.key.windowID);
-          toggleFullscreen(dataPtr);          
+
+      case JDI_POST_UPDATE_WIDGET:
+      case JDI_POST_RESIZE_WIDGET:
+        {
+          widget_ptr widget = request.widget.lock();
+          auto dataPtr = widget ? getDataByWidget(widget) : nullptr;
+          if(dataPtr != nullptr) {
+            if(request.kind == JDI_POST_UPDATE_WIDGET) dataPtr->willUpdate = true;
+            else                                       dataPtr->willResize = true;
+          }
         }
         break;
         
-      case SDL_WINDOWEVENT:
+      case JDI_POST_UPDATE_WINDOW:
+      case JDI_POST_RESIZE_WINDOW:
         {
-          switch(event.window.event) {
-          case SDL_WINDOWEVENT_SHOWN:
-          case SDL_WINDOWEVENT_EXPOSED:
-            {
-              auto dataPtr = getDataByWindowID(event.window.windowID);
-              if(dataPtr != nullptr) {
-                dataPtr->willUpdate = true;
-              }
-              break;
-            }
-            
-          case SDL_WINDOWEVENT_SIZE_CHANGED:
-          case SDL_WINDOWEVENT_DISPLAY_CHANGED:
-            {
-              auto dataPtr = getDataByWindowID(event.window.windowID);
-              if(dataPtr != nullptr) {
-                updateRenderer(dataPtr);
-              }
-              break;
-            }
-            
-          case SDL_WINDOWEVENT_CLOSE:
-            {
-              auto dataPtr = getDataByWindowID(event.window.windowID);
-              if(dataPtr != nullptr) {
-                removeWindow(dataPtr->window);
-              }
-              break;
-            }
+          window_ptr window = request.window.lock();
+          auto dataPtr = window ? getDataByWindow(window) : nullptr;
+          if(dataPtr != nullptr) {
+            if(request.kind == JDI_POST_UPDATE_WINDOW) dataPtr->willUpdate = true;
+            else                                       dataPtr->willResize = true;
           }
         }
         break;
 
-      case SDL_JOYDEVICEADDED:
-        addJoystick(event.jdevice.which);
+      case JDI_POST_UPDATE_ALL:
+        requestUpdateAll();
         break;
 
-      case SDL_JOYDEVICEREMOVED:
-        removeJoystick(event.jdevice.which);
+      case JDI_POST_RESIZE_ALL:
+        requestResizeAll();
         break;
-        
-      default:
-        if(event.type == jdiEventType) {
-          // Animate events are automatically handled as part of checking for
-          // updates.  No need to do anything.  In fact, just firing the event
-          // is the whole point.
-        }
-        
-        
       }
+    }
+  }
+  
+  // SDL has one queue per process, so we pull other engines' events too.
+  // An event for a window another engine owns, or another engine's wake-up,
+  // is handed to that engine's post queue, to be handled on its own thread
+  // at its next pass.  True if it went elsewhere.
+  bool Engine::forwardEvent(const SDL_Event& event) {
+    bool isForeignJDI = event.type >= SDL_USEREVENT && event.type != _jdiEventType;
+    Uint32 windowID = event.type == _jdiEventType ? 0 : getEventWindowID(event);
+    if(windowID != 0 && getDataByWindowID(windowID) != nullptr) return(false);  // Ours
+    if(windowID == 0 && !isForeignJDI) return(false);                           // Everyone's
+
+    event_filter_state_type& state = getEventFilterState();
+    std::lock_guard<std::mutex> lock(state.mutex);  // Holds the owner alive
+    Engine* owner = nullptr;
+    if(windowID != 0) {
+      auto found = state.windowOwners.find(windowID);
+      if(found != state.windowOwners.end()) owner = found->second;
+    } else {
+      for(Engine* engine : state.engines) {
+        if(engine->_jdiEventType == event.type) owner = engine;
+      }
+    }
+    if(owner == nullptr || owner == this) return(false);
+
+    if(windowID == 0) {
+      // We ate its wake-up, which it still thinks is queued
+      owner->_isWakePending.store(false);
+      owner->postRequest(post_datum_type{JDI_POST_CALL});
+    } else {
+      SDL_Event copy = event;
+      owner->postRequest(post_datum_type{JDI_POST_CALL, {}, {},
+            [owner, copy]() mutable { owner->handleEvent(copy); }});
+    }
+    return(true);
+  }
+  
+  // Engine housekeeping for a single event, then hand it to the widgets.
+  void Engine::handleEvent(SDL_Event& event) {
+    const Uint32 jdiEventType = _jdiEventType;
+
+    if(forwardEvent(event)) return;
+
+    recordInputEdge(event);
+    
+    switch(event.type) {
+      
+    case SDL_QUIT:
+      _willExit = true;
+      break;
+      
+    case SDL_RENDER_TARGETS_RESET:
+      handleRenderReset(false);
+      break;
+
+    case SDL_RENDER_DEVICE_RESET:
+      handleRenderReset(true);
+      break;
+      
+    case SDL_KEYUP:
+      if(event.key.keysym.sym == SDLK_F11) {
+        auto dataPtr = getDataByWindowID(event.key.windowID);
+        toggleFullscreen(dataPtr);          
+      }
+      break;
       
-      if(_windowData.empty()) {
-        _willExit = true;
-      } else {
-        if(event.type != jdiEventType) {
-          // Do not propagate jdiEvents to the widgets.
+    case SDL_WINDOWEVENT:
+      {
+        switch(event.window.event) {
+        case SDL_WINDOWEVENT_SHOWN:
+        case SDL_WINDOWEVENT_EXPOSED:
+          {
+            auto dataPtr = getDataByWindowID(event.window.windowID);
+            if(dataPtr != nullptr) {
+              dataPtr->willUpdate = true;
+            }
+            break;
+          }
+          
+        case SDL_WINDOWEVENT_SIZE_CHANGED:
+          {
+            // Same renderer, new size:  lay out and redraw on the next frame
+            auto dataPtr = getDataByWindowID(event.window.windowID);
+            if(dataPtr != nullptr) {
+              dataPtr->willResize = true;
+              dataPtr->willUpdate = true;
+            }
+            break;
+          }
+          
+        case SDL_WINDOWEVENT_DISPLAY_CHANGED:
+          {
+            auto dataPtr = getDataByWindowID(event.window.windowID);
+            if(dataPtr != nullptr) {
+              updateDisplayMode(dataPtr);
+              updateRenderer(dataPtr);
+            }
+            break;
+          }
           
-          window_datum_type* focusDataPtr = getEventFocus(event);
-          bool isHandled=false;
+        case SDL_WINDOWEVENT_LEAVE:
+          {
+            auto dataPtr = getDataByWindowID(event.window.windowID);
+            if(dataPtr != nullptr) {
+              updateHover(dataPtr, std::vector<widget_ptr>());
+            }
+            break;
+          }
           
-          if(focusDataPtr != nullptr) {
-            isHandled = sendEvent(focusDataPtr, &event);
-          } else {
-            for(auto& data : _windowData) {
-              if(isHandled) break;
-              isHandled = sendEvent(&data, &event);
+        case SDL_WINDOWEVENT_CLOSE:
+          {
+            auto dataPtr = getDataByWindowID(event.window.windowID);
+            if(dataPtr != nullptr) {
+              removeWindow(dataPtr->window);
             }
+            break;
           }
         }
-        
+      }
+      break;
+
+    case SDL_JOYDEVICEADDED:
+      addJoystick(event.jdevice.which);
+      break;
+
+    case SDL_JOYDEVICEREMOVED:
+      removeJoystick(event.jdevice.which);
+      break;
+      
+    default:
+      if(event.type == jdiEventType) {
+        // JDI events exist only to wake the loop so that it checks for
+        // updates.  Receiving one is the whole point.
+      }
+      
+      
+    }
+    
+    if(!_windowByID.empty() && event.type != jdiEventType) {
+      // Do not propagate jdiEvents to the widgets.
+      
+      Uint32 windowID = getEventWindowID(event);
+      bool isHandled=false;
+      
+      if(windowID != 0) {
+        // Only to the window it was aimed at, if that one is ours
+        window_datum_type* focusDataPtr = getDataByWindowID(windowID);
+        if(focusDataPtr != nullptr) {
+          isHandled = sendEvent(focusDataPtr, &event);
+        }
+      } else {
         for(auto& data : _windowData) {
-          resizeWidgets(&data);
-          updateWidgets(&data);          
+          if(isHandled) break;
+          if(data.isRemoved) continue;
+          isHandled = sendEvent(&data, &event);
         }
       }
     }
   }
   
+  bool Engine::canCoalesce(const SDL_Event& into, const SDL_Event& event) {
+    if(into.type != event.type) return(false);
+    
+    switch(event.type) {
+    case SDL_MOUSEMOTION:
+      return(into.motion.windowID == event.motion.windowID &&
+             into.motion.which == event.motion.which &&
+             into.motion.state == event.motion.state);
+    case SDL_MOUSEWHEEL:
+      return(into.wheel.windowID == event.wheel.windowID &&
+             into.wheel.which == event.wheel.which &&
+             into.wheel.direction == event.wheel.direction);
+    case SDL_FINGERMOTION:
+      return(into.tfinger.windowID == event.tfinger.windowID &&
+             into.tfinger.touchId == event.tfinger.touchId &&
+             into.tfinger.fingerId == event.tfinger.fingerId);
+    default:
+      return(false);
+    }
+  }
+
+  // The later event wins, apart from the deltas, which add up.  Copying it
+  // whole keeps whatever fields newer SDLs add.
+  void Engine::coalesceEvent(SDL_Event& into, const SDL_Event& event) {
+    switch(event.type) {
+    case SDL_MOUSEMOTION:
+      {
+        Sint32 xrel = into.motion.xrel + event.motion.xrel;
+        Sint32 yrel = into.motion.yrel + event.motion.yrel;
+        into = event;
+        into.motion.xrel = xrel;
+        into.motion.yrel = yrel;
+      }
+      break;
+    case SDL_MOUSEWHEEL:
+      {
+        Sint32 x = into.wheel.x + event.wheel.x;
+        Sint32 y = into.wheel.y + event.wheel.y;
+        float preciseX = into.wheel.preciseX + event.wheel.preciseX;
+        float preciseY = into.wheel.preciseY + event.wheel.preciseY;
+        into = event;
+        into.wheel.x = x;
+        into.wheel.y = y;
+        into.wheel.preciseX = preciseX;
+        into.wheel.preciseY = preciseY;
+      }
+      break;
+    case SDL_FINGERMOTION:
+      {
+        float dx = into.tfinger.dx + event.tfinger.dx;
+        float dy = into.tfinger.dy + event.tfinger.dy;
+        into = event;
+        into.tfinger.dx = dx;
+        into.tfinger.dy = dy;
+      }
+      break;
+    }
+  }
+
+  // Anything that breaks a run sends the merged event first, so widgets
+  // still see events in the order they happened.
+  void Engine::dispatchEvent(SDL_Event& event) {
+    if(_coalescing.type != 0) {
+      if(canCoalesce(_coalescing, event)) {
+        coalesceEvent(_coalescing, event);
+        _coalescingSamples.push_back(event);
+        return;
+      }
+      flushCoalesced();
+    }
+
+    if(_isCoalescing &&
+       (event.type == SDL_MOUSEMOTION || event.type == SDL_MOUSEWHEEL ||
+        event.type == SDL_FINGERMOTION)) {
+      _coalescing = event;
+      _coalescingSamples.assign(1, event);
+      return;
+    }
+    
+    handleEvent(event);
+  }
+
+  void Engine::flushCoalesced() {
+    if(_coalescing.type == 0) return;
+
+    SDL_Event event = _coalescing;
+    _coalescing.type = 0;
+    if(_coalescingSamples.size() > 1) _coalescedSamples.swap(_coalescingSamples);  // A lone event merged nothing
+    _coalescingSamples.clear();
+
+    try {
+      handleEvent(event);
+    }
+    catch(...) {
+      _coalescedSamples.clear();
+      throw;
+    }
+    _coalescedSamples.clear();
+  }
+  
+  bool Engine::step(Sint32 timeoutTicks) {
+    // Read from other threads by isEngineThread(); only written on a move
+    SDL_threadID threadID = SDL_ThreadID();
+    if(_threadID.load() != threadID) _threadID.store(threadID);
+    refreshListeners();
+    
+    SDL_Event event;
+    bool hasEvent = waitForEvent(event, timeoutTicks);
+
+    _isDispatching = true;
+    try {
+      runPosted();
+
+      // At most once a frame, so a handler which keeps republishing for the
+      // next frame doesn't spin the loop
+      Uint64 busNowHRC = SDL_GetPerformanceCounter();
+      if(_bus.hasQueued(JDI_DELIVER_NEXT_FRAME) && busNowHRC >= getBusDeadline()) {
+        _busFrameHRC = busNowHRC;
+        _bus.deliver(JDI_DELIVER_NEXT_FRAME);
+      }
+
+      // Drain whatever else is already queued (within budget) so that a burst
+      // of input costs one layout and one draw per window, not one per event.
+      Uint64 dispatchStart = SDL_GetTicks64();
+      Uint32 eventCount = 0;
+
+      while(hasEvent && !_willExit) {
+        dispatchEvent(event);
+        ++eventCount;
+
+        hasEvent =
+          (_maxEventsPerFrame == 0 || eventCount < _maxEventsPerFrame) &&
+          (_maxEventTicksPerFrame == 0 ||
+           SDL_GetTicks64() - dispatchStart < _maxEventTicksPerFrame) &&
+          SDL_PollEvent(&event) == 1;
+      }
+      flushCoalesced();
+
+      if(_windowByID.empty() && !_isHeadless) {
+        _willExit = true;
+      } else {
+        if(!_isHeadless) snapshotInput();
+        runUpdates();
+        _bus.deliver(JDI_DELIVER_SAME_FRAME);
+        drawDueWindows();
+      }
+    }
+    catch(...) {
+      // Leave the engine fit for another pass
+      _isDispatching = false;
+      reapWindows();
+      throw;
+    }
+
+    _isDispatching = false;
+    reapWindows();
+
+    return(!_willExit);
+  }
+  
+  void Engine::mainLoop() {
+    clearExit();
+    
+    while(step()) {}
+  }
+  
 } // end namespace jdi
@@ -46,6 +46,14 @@ namespace jdi {
     }
   }
 
+  void Grid::onRecord(DrawList& list) {
+    for(auto& childData : _children) {
+      if(childData.widget->isVisible()) {
+        childData.widget->onRecord(list);
+      }
+    }
+  }
+
   void Grid::onResize(renderer_ptr renderer) {
     weight_container_type rowHeights(_rowWeight.size());
     weight_container_type colWidths(_colWeight.size());
@@ -277,6 +285,7 @@ namespace jdi {
   grid_ptr Grid::create() {
     grid_ptr reply(new Grid());
     reply->setSelf(reply);
+    reply->setEventMask(JDI_EVENTS_NONE);  // Layout only
 
     return(reply);    
   }
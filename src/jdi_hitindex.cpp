@@ -0,0 +1,102 @@
+// File: jdi_hitindex.cpp
+// ----
+// Finding widgets by position.
+
+#include <algorithm>
+
+#include "jdi.hpp"
+
+namespace jdi {
+
+  // Big enough that a cell holds a handful of widgets, small enough that a
+  // full-screen window stays a few hundred cells.
+  const int hitCellSize = 64;
+
+  HitIndex::HitIndex() :
+    _bounds{0, 0, 0, 0},
+    _cols(0),
+    _rows(0),
+    _isBuilt(false)
+  {}
+
+  bool HitIndex::isShown(const widget_ptr& widget) {
+    for(widget_ptr iter = widget; iter; iter = iter->getParent()) {
+      if(!iter->isVisible()) return(false);
+    }
+    return(true);
+  }
+
+  void HitIndex::clear() {
+    _widgets.clear();
+    _numbers.clear();
+    _cells.clear();
+    _cols = 0;
+    _rows = 0;
+    _isBuilt = false;
+  }
+
+  void HitIndex::rebuild(widget_ptr root, const SDL_Rect* bounds) {
+    clear();
+    _isBuilt = true;
+    if(!root || bounds == nullptr || bounds->w <= 0 || bounds->h <= 0) return;
+
+    _bounds = *bounds;
+    _cols = (_bounds.w + hitCellSize - 1) / hitCellSize;
+    _rows = (_bounds.h + hitCellSize - 1) / hitCellSize;
+    _cells.resize(size_t(_cols) * size_t(_rows));
+
+    for(widget_ptr iter = root->getFirstPreOrderDFS();
+        iter; iter = root->getNextPreOrderDFS(iter)) {
+      if(!isShown(iter)) continue;
+
+      int number = int(_widgets.size());
+      _widgets.push_back(iter);
+      _numbers[iter.get()] = number;
+
+      SDL_Rect area;
+      if(!SDL_IntersectRect(iter->getDrawRect(), &_bounds, &area)) continue;
+
+      int col0 = (area.x - _bounds.x) / hitCellSize;
+      int row0 = (area.y - _bounds.y) / hitCellSize;
+      int col1 = (area.x + area.w - 1 - _bounds.x) / hitCellSize;
+      int row1 = (area.y + area.h - 1 - _bounds.y) / hitCellSize;
+      for(int row = row0; row <= row1; ++row) {
+        for(int col = col0; col <= col1; ++col) {
+          _cells[size_t(row) * size_t(_cols) + size_t(col)].push_back(number);
+        }
+      }
+    }
+  }
+
+  void HitIndex::hitTest(const SDL_Point* point, std::vector<widget_ptr>& hits) const {
+    hits.clear();
+    if(_cells.empty() || !SDL_PointInRect(point, &_bounds)) return;
+
+    int col = (point->x - _bounds.x) / hitCellSize;
+    int row = (point->y - _bounds.y) / hitCellSize;
+    const index_seq_type& cell = _cells[size_t(row) * size_t(_cols) + size_t(col)];
+
+    index_seq_type numbers;
+    for(int number : cell) {
+      widget_ptr widget = _widgets[number].lock();
+      if(!widget || !isShown(widget) || !widget->isInside(point)) continue;
+
+      // The widget and its ancestors, until we reach one already counted
+      for(; widget; widget = widget->getParent()) {
+        int ancestor = getNumber(widget.get());
+        if(ancestor < 0 ||
+           std::find(numbers.begin(), numbers.end(), ancestor) != numbers.end()) {
+          break;
+        }
+        numbers.push_back(ancestor);
+      }
+    }
+
+    std::sort(numbers.begin(), numbers.end(), std::greater<int>());
+    for(int number : numbers) {
+      widget_ptr widget = _widgets[number].lock();
+      if(widget) hits.push_back(widget);
+    }
+  }
+
+} // end namespace jdi
@@ -0,0 +1,47 @@
+// File: jdi_input.cpp
+// ----
+// Input snapshots.
+
+#include <algorithm>
+
+#include "jdi.hpp"
+
+namespace jdi {
+
+  InputState::InputState() :
+    _keys(SDL_NUM_SCANCODES, 0),
+    _keysPressed(SDL_NUM_SCANCODES, 0),
+    _keysReleased(SDL_NUM_SCANCODES, 0),
+    _modifiers(0),
+    _mouseX(0),
+    _mouseY(0),
+    _mouseWindowID(0),
+    _buttons(0),
+    _buttonsPressed(0),
+    _buttonsReleased(0),
+    _wheelX(0),
+    _wheelY(0),
+    _serial(0)
+  {}
+
+  void InputState::clearEdges() {
+    std::fill(_keysPressed.begin(), _keysPressed.end(), 0);
+    std::fill(_keysReleased.begin(), _keysReleased.end(), 0);
+    _buttonsPressed = 0;
+    _buttonsReleased = 0;
+    _wheelX = 0;
+    _wheelY = 0;
+    for(auto& joystick : _joysticks) {
+      std::fill(joystick.pressed.begin(), joystick.pressed.end(), 0);
+      std::fill(joystick.released.begin(), joystick.released.end(), 0);
+    }
+  }
+
+  const InputState::joystick_state_type* InputState::getJoystick(SDL_JoystickID id) const {
+    for(auto& joystick : _joysticks) {
+      if(joystick.id == id) return(&joystick);
+    }
+    return(nullptr);
+  }
+
+} // end namespace jdi
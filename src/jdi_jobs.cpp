@@ -0,0 +1,131 @@
+// File: jdi_jobs.cpp
+// ----
+// Worker threads with work stealing.
+
+#include "jdi.hpp"
+
+namespace jdi {
+
+  // Which pool and worker, if any, the calling thread belongs to
+  struct current_worker_type {
+    const JobPool* pool;
+    size_t         index;
+  };
+
+  thread_local current_worker_type currentWorker = {nullptr, 0};
+
+
+  JobPool::JobPool(size_t threadCount) :
+    _pendingJobs(0),
+    _nextWorker(0),
+    _willStop(false)
+  {
+    if(threadCount == 0) {
+      size_t hardware = std::thread::hardware_concurrency();
+      threadCount = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    for(size_t i = 0; i < threadCount; ++i) {
+      _workers.push_back(std::unique_ptr<worker_type>(new worker_type));
+    }
+
+    // Start threads only once every deque exists, since they steal
+    for(size_t i = 0; i < threadCount; ++i) {
+      _workers[i]->thread = std::thread(&JobPool::runWorker, this, i);
+    }
+  }
+
+  JobPool::~JobPool() {
+    {
+      std::lock_guard<std::mutex> lock(_sleepMutex);
+      _willStop = true;
+    }
+    _wake.notify_all();
+
+    for(auto& worker : _workers) {
+      if(worker->thread.joinable()) worker->thread.join();
+    }
+  }
+
+  bool JobPool::isWorkerThread() const {
+    return(currentWorker.pool == this);
+  }
+
+  void JobPool::submit(job_type job, job_priority_type priority) {
+    if(!job) return;
+    if(priority < 0 || priority >= JDI_PRIORITY_COUNT) {
+      throw(std::logic_error("JobPool::submit:  Unknown priority"));
+    }
+
+    size_t target = isWorkerThread() ? currentWorker.index
+      : _nextWorker.fetch_add(1) % _workers.size();
+
+    {
+      std::lock_guard<std::mutex> lock(_workers[target]->mutex);
+      _workers[target]->jobs[priority].push_back(std::move(job));
+      ++_pendingJobs;
+    }
+
+    // Taking the lock means a worker can't miss this between its check and
+    // its wait
+    { std::lock_guard<std::mutex> lock(_sleepMutex); }
+    _wake.notify_one();
+  }
+
+  bool JobPool::takeJob(size_t self, job_type& job) {
+    const size_t count = _workers.size();
+
+    for(int priority = 0; priority < JDI_PRIORITY_COUNT; ++priority) {
+      // Our own newest job first
+      {
+        worker_type& worker = *_workers[self];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        auto& jobs = worker.jobs[priority];
+        if(!jobs.empty()) {
+          job = std::move(jobs.back());
+          jobs.pop_back();
+          --_pendingJobs;
+          return(true);
+        }
+      }
+
+      // Then steal the oldest from someone else
+      for(size_t i = 1; i < count; ++i) {
+        worker_type& victim = *_workers[(self + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        auto& jobs = victim.jobs[priority];
+        if(!jobs.empty()) {
+          job = std::move(jobs.front());
+          jobs.pop_front();
+          --_pendingJobs;
+          return(true);
+        }
+      }
+    }
+
+    return(false);
+  }
+
+  void JobPool::runWorker(size_t self) {
+    currentWorker = current_worker_type{this, self};
+
+    for(;;) {
+      job_type job;
+
+      if(takeJob(self, job)) {
+        try {
+          job();
+        }
+        catch(...) {
+          // There's nobody on this thread to tell
+        }
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(_sleepMutex);
+      _wake.wait(lock, [this]{ return(_willStop || _pendingJobs.load() > 0); });
+      if(_willStop) return;
+    }
+  }
+
+} // end namespace jdi
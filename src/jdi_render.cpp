@@ -0,0 +1,211 @@
+// File: jdi_render.cpp
+// ----
+// Draw lists and the render thread.
+
+#include "jdi.hpp"
+
+namespace jdi {
+
+  ////
+  // DrawList
+  ////
+  DrawList::DrawList() :
+    _isSynced(false)
+  {}
+
+  void DrawList::add(op_type op, const SDL_Rect* tgt, const SDL_Rect* src,
+                     int index) {
+    command_type command;
+    command.op = op;
+    command.tgt = tgt == nullptr ? SDL_Rect{0, 0, 0, 0} : *tgt;
+    command.src = src == nullptr ? SDL_Rect{0, 0, 0, 0} : *src;
+    command.index = index;
+    _commands.push_back(command);
+  }
+
+  void DrawList::drawSprite(sprite_ptr sprite, const SDL_Rect* tgtRect,
+                            int element) {
+    if(!sprite) return;
+    SDL_Rect src = {element, 0, 0, 0};
+    _sprites.push_back(sprite);
+    add(JDI_DRAW_SPRITE, tgtRect, &src, int(_sprites.size() - 1));
+  }
+
+  void DrawList::drawTexture(texture_ptr texture, const SDL_Rect* srcRect,
+                             const SDL_Rect* tgtRect) {
+    if(!texture) return;
+    _textures.push_back(texture);
+    add(JDI_DRAW_TEXTURE, tgtRect, srcRect, int(_textures.size() - 1));
+  }
+
+  void DrawList::call(call_type call) {
+    if(!call) return;
+    _calls.push_back(std::move(call));
+    add(JDI_DRAW_CALL, nullptr, nullptr, int(_calls.size() - 1));
+  }
+
+  void DrawList::callSynced(call_type call) {
+    if(!call) return;
+    _calls.push_back(std::move(call));
+    add(JDI_DRAW_CALL, nullptr, nullptr, int(_calls.size() - 1));
+    _isSynced = true;
+  }
+
+  void DrawList::reset() {
+    _commands.clear();
+    _sprites.clear();
+    _textures.clear();
+    _calls.clear();
+    _isSynced = false;
+  }
+
+  void DrawList::resolveSprites(renderer_ptr renderer, RenderThread* thread) {
+    for(auto& command : _commands) {
+      if(command.op != JDI_DRAW_SPRITE) continue;
+
+      const sprite_ptr& sprite = _sprites[command.index];
+      if(!sprite->hasTextureFrom(renderer)) {
+        if(thread) thread->runAndWait([&]() { sprite->generateTexture(renderer); });
+        else       sprite->generateTexture(renderer);
+      }
+
+      SDL_Rect src;
+      texture_ptr texture = sprite->getTexture();
+      if(!texture || !sprite->getSrcBBox(&src, command.src.x)) {
+        command.op = JDI_DRAW_NOTHING;
+        continue;
+      }
+      _textures.push_back(texture);
+      command.op = JDI_DRAW_TEXTURE;
+      command.src = src;
+      command.index = int(_textures.size() - 1);
+    }
+    _sprites.clear();
+  }
+
+  void DrawList::replay(renderer_ptr renderer) {
+    SDL_Renderer* sdlRenderer = renderer.get();
+    
+    for(const auto& command : _commands) {
+      const SDL_Rect* tgt = &command.tgt;
+      
+      switch(command.op) {
+      case JDI_DRAW_COLOR:
+        SDL_SetRenderDrawColor(sdlRenderer, command.color.r, command.color.g,
+                               command.color.b, command.color.a);
+        break;
+      case JDI_DRAW_CLEAR:
+        safely(SDL_RenderClear(sdlRenderer));
+        break;
+      case JDI_DRAW_FILL:
+        SDL_RenderFillRect(sdlRenderer, tgt);
+        break;
+      case JDI_DRAW_RECT:
+        SDL_RenderDrawRect(sdlRenderer, tgt);
+        break;
+      case JDI_DRAW_LINE:
+        SDL_RenderDrawLine(sdlRenderer, tgt->x, tgt->y, tgt->w, tgt->h);
+        break;
+      case JDI_DRAW_CLIP:
+        SDL_RenderSetClipRect(sdlRenderer, tgt);
+        break;
+      case JDI_DRAW_UNCLIP:
+        SDL_RenderSetClipRect(sdlRenderer, nullptr);
+        break;
+      case JDI_DRAW_SPRITE:
+        {
+          const sprite_ptr& sprite = _sprites[command.index];
+          if(!sprite->hasTextureFrom(renderer)) sprite->generateTexture(renderer);
+          sprite->drawFull(renderer, tgt, command.src.x);
+        }
+        break;
+      case JDI_DRAW_TEXTURE:
+        SDL_RenderCopy(sdlRenderer, _textures[command.index].get(),
+                       command.src.w == 0 ? nullptr : &command.src, tgt);
+        break;
+      case JDI_DRAW_CALL:
+        _calls[command.index](renderer);
+        break;
+      case JDI_DRAW_NOTHING:
+        break;
+      }
+    }
+  }
+
+
+  ////
+  // RenderThread
+  ////
+  RenderThread::RenderThread() :
+    _willStop(false)
+  {
+    _thread = std::thread(&RenderThread::runThread, this);
+  }
+
+  RenderThread::~RenderThread() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _willStop = true;
+    }
+    _wake.notify_all();
+    if(_thread.joinable()) _thread.join();
+  }
+
+  bool RenderThread::isRenderThread() const {
+    return(std::this_thread::get_id() == _thread.get_id());
+  }
+
+  void RenderThread::run(task_type task) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _tasks.push_back(std::move(task));
+    }
+    _wake.notify_one();
+  }
+
+  void RenderThread::runAndWait(task_type task) {
+    if(isRenderThread()) {
+      task();
+      return;
+    }
+    
+    std::exception_ptr error;
+    bool isDone = false;
+    
+    run([&]() {
+        try { task(); } catch(...) { error = std::current_exception(); }
+        std::lock_guard<std::mutex> lock(_mutex);
+        isDone = true;
+        _done.notify_all();
+      });
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [&]{ return(isDone); });
+    lock.unlock();
+    
+    if(error) std::rethrow_exception(error);
+  }
+
+  void RenderThread::runThread() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    
+    for(;;) {
+      _wake.wait(lock, [this]{ return(_willStop || !_tasks.empty()); });
+      if(_tasks.empty()) return;  // Stopping, and drained
+
+      task_type task = std::move(_tasks.front());
+      _tasks.pop_front();
+      lock.unlock();
+
+      try {
+        task();
+      }
+      catch(...) {
+        // Fire-and-forget tasks have nobody to report to
+      }
+
+      lock.lock();
+    }
+  }
+  
+} // end namespace jdi
@@ -6,7 +6,67 @@
 
 namespace jdi {
 
-  Sprite::~Sprite() {}
+  // Sprites with textures, by address.  Guarded, since sprites may be built
+  // on worker threads.
+  struct texture_registry_type {
+    std::mutex                                          mutex;
+    std::unordered_map<const Sprite*, sprite_ptr::weak_type> sprites;
+  };
+
+  texture_registry_type& getTextureRegistry() {
+    static texture_registry_type _registry;
+
+    return(_registry);
+  }
+  
+  Sprite::Sprite() :
+    _w(0),
+    _h(0),
+    _rows(0),
+    _cols(0)
+  {}
+  
+  Sprite::~Sprite() {
+    texture_registry_type& registry = getTextureRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.sprites.erase(this);
+  }
+
+  texture_ptr Sprite::generateTexture(renderer_ptr renderer) {
+    _texture.reset();
+    _textureRenderer.reset();
+    if(renderer && _surface) {
+      _texture = sdl_shared(SDL_CreateTextureFromSurface(renderer.get(),
+                                                         _surface.get()));
+      _textureRenderer = renderer;
+
+      sprite_ptr::weak_type self = weak_from_this();
+      if(!self.expired()) {
+        texture_registry_type& registry = getTextureRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.sprites[this] = self;
+      }
+    }
+    return(_texture);
+  }
+
+  std::vector<sprite_ptr> Sprite::getTexturedSprites(const renderer_ptr& renderer) {
+    std::vector<sprite_ptr::weak_type> candidates;
+    {
+      texture_registry_type& registry = getTextureRegistry();
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      for(auto& entry : registry.sprites) candidates.push_back(entry.second);
+    }
+
+    // Locked outside the registry:  dropping the last reference to a sprite
+    // here unregisters it.
+    std::vector<sprite_ptr> reply;
+    for(auto& candidate : candidates) {
+      sprite_ptr sprite = candidate.lock();
+      if(sprite && sprite->hasTextureFrom(renderer)) reply.push_back(sprite);
+    }
+    return(reply);
+  }
   
   surface_ptr Sprite::claimSurface(SDL_Surface* sdl_surface,
                                    int elementW, int elementH) {
@@ -294,6 +354,10 @@ namespace jdi {
   sprite_ptr Sprite::createFromImage(const char* file,
                                      int elementW,
                                      int elementH) {
+    if(!Engine::requireSubsystem(JDI_SUBSYSTEM_IMAGE)) {
+      throw(std::logic_error("Images are disabled by the engine configuration!"));
+    }
+    
     sprite_ptr reply = sprite_ptr(new Sprite);
     reply->claimSurface(IMG_Load(file),
                         elementW,
@@ -301,5 +365,23 @@ namespace jdi {
 
     return(reply);
   }
+
+  void Sprite::createFromImageAsync(engine_ptr engine,
+                                    const char* file,
+                                    std::function<void(sprite_ptr)> then,
+                                    int elementW,
+                                    int elementH,
+                                    JobPool::error_type fail) {
+    // Bring SDL_image up here, not on a worker
+    if(!Engine::requireSubsystem(JDI_SUBSYSTEM_IMAGE)) {
+      throw(std::logic_error("Images are disabled by the engine configuration!"));
+    }
+
+    std::string path(file);
+    engine->runJobThen([path, elementW, elementH]() {
+        return(createFromImage(path.c_str(), elementW, elementH));
+      },
+      then, fail);
+  }
   
 } // end namespace jdi
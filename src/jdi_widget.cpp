@@ -9,6 +9,9 @@ namespace jdi {
   Widget::Widget() :
     _isEnabled(true),
     _isVisible(true),
+    _eventMask(JDI_EVENTS_ALL),
+    _isShortcutListener(false),
+    _isSimulating(false),
     _padN(0),
     _padS(0),
     _padE(0),
@@ -18,29 +21,67 @@ namespace jdi {
     _anchors(JDI_NONE),
     _drawRect(),
     _self(),
-    _parent() {
+    _parent(),
+    _windowID(0),
+    _engine() {
   }
 
   bool Widget::claimChild(widget_ptr child) {    
-    engine_ptr engine = Engine::getEngine();
+    engine_ptr engine = _engine.lock();
     widget_ptr parent = _self.lock();
     
-    if(child->_parent.lock() || engine->getWindow(child)) {
+    if(child->_parent.lock() || child->_windowID != 0) {
       return(false); // Can't reparent
     }
     
     child->_parent = parent;
 
-    renderer_ptr renderer = engine->getRenderer(parent);
-    if(renderer) {
-      for(widget_ptr iter = child->getFirstPreOrderDFS();
-          iter; iter = child->getNextPreOrderDFS(iter)) {
-        iter->onRenderUpdate(renderer);
-      }
+    renderer_ptr renderer = engine ? engine->getRenderer(parent) : renderer_ptr();
+    for(widget_ptr iter = child->getFirstPreOrderDFS();
+        iter; iter = child->getNextPreOrderDFS(iter)) {
+      iter->_windowID = _windowID;
+      iter->_engine = _engine;
+      if(renderer) iter->onRenderUpdate(renderer);
+    }
+    if(engine) {
+      engine->invalidateListeners(_windowID);
+      engine->invalidateHitIndex(_windowID);
     }
     
     return(true);
   }
+
+  void Widget::setVisible(bool visible) {
+    if(visible == _isVisible) return;
+
+    _isVisible = visible;
+    engine_ptr engine = _engine.lock();
+    if(engine) engine->invalidateHitIndex(_windowID);
+  }
+
+  void Widget::setEventMask(Uint32 mask) {
+    if(mask == _eventMask) return;
+
+    _eventMask = mask;
+    engine_ptr engine = _engine.lock();
+    if(engine) engine->invalidateListeners(_windowID);
+  }
+
+  void Widget::setShortcutListener(bool listen) {
+    if(listen == _isShortcutListener) return;
+
+    _isShortcutListener = listen;
+    engine_ptr engine = _engine.lock();
+    if(engine) engine->invalidateListeners(_windowID);
+  }
+  
+  void Widget::setSimulating(bool simulate) {
+    if(simulate == _isSimulating) return;
+
+    _isSimulating = simulate;
+    engine_ptr engine = _engine.lock();
+    if(engine) engine->invalidateListeners(_windowID);
+  }
   
   Widget::~Widget() {}
   
@@ -85,8 +126,17 @@ namespace jdi {
 
   void Widget::onRenderUpdate(renderer_ptr renderer) {}
 
+  void Widget::onRenderReset(renderer_ptr renderer, bool isDeviceLost) {}
+
   void Widget::onDraw(renderer_ptr renderer) {}
 
+  void Widget::onRecord(DrawList& list) {
+    widget_ptr self = getSelf();
+    if(self) list.callSynced([self](renderer_ptr renderer) { self->onDraw(renderer); });
+  }
+
+  void Widget::onUpdate(Uint32 ticks) {}
+
   void Widget::onResize(renderer_ptr renderer) {}
 
   bool Widget::onTakeFocus(renderer_ptr renderer) { return(false); }
@@ -96,6 +146,13 @@ namespace jdi {
   bool Widget::onEvent(renderer_ptr renderer,
                        SDL_Event* event) { return(false); }
 
+  bool Widget::onCaptureEvent(renderer_ptr renderer,
+                              SDL_Event* event) { return(false); }
+
+  void Widget::onMouseEnter(renderer_ptr renderer) {}
+
+  void Widget::onMouseLeave(renderer_ptr renderer) {}
+
   bool Widget::hasChildren() const { return(false); }
 
   bool Widget::hasChild(widget_ptr child) const { return(false); }
@@ -0,0 +1,64 @@
+// File: bench_cache_test.cpp
+// ----
+// The "auto" renderer driver is measured once, then remembered:  by the
+// engine for later windows, and under the preferences directory for later
+// starts.
+
+#include "jdi.hpp"
+
+int failures = 0;
+
+void check(bool isOK, const char* what) {
+  if(!isOK) {
+    SDL_Log("FAILED:  %s", what);
+    ++failures;
+  }
+}
+
+jdi::engine_ptr startEngine() {
+  jdi::EngineConfig config;
+  config.controller = jdi::JDI_SUBSYSTEM_OFF;
+  config.image = jdi::JDI_SUBSYSTEM_OFF;
+  config.ttf = jdi::JDI_SUBSYSTEM_OFF;
+  config.audio = jdi::JDI_SUBSYSTEM_OFF;
+  config.rendererDriver = "auto";
+
+  jdi::engine_ptr engine = jdi::Engine::create(config);
+  engine->registerApp("jdi", "bench_cache_test");
+  return(engine);
+}
+
+int main(int argc, char* argv[]) {
+  std::filesystem::path cachePath;
+
+  try {
+    {
+      jdi::engine_ptr engine = startEngine();
+      check(!engine->getPrefPath().empty(), "a preferences directory");
+      cachePath = engine->getPrefPath() / "renderer-driver.txt";
+      std::filesystem::remove(cachePath);
+
+      engine->createWindow("first", 0, 0, 64, 64, SDL_WINDOW_HIDDEN);
+      check(engine->getBenchmarkCount() == 1, "the first window measures");
+      check(std::filesystem::exists(cachePath), "the winner is written out");
+
+      engine->createWindow("second", 0, 0, 64, 64, SDL_WINDOW_HIDDEN);
+      check(engine->getBenchmarkCount() == 1, "the same flags measure once");
+    }
+
+    {
+      // As if the program started again
+      jdi::engine_ptr engine = startEngine();
+      engine->createWindow("again", 0, 0, 64, 64, SDL_WINDOW_HIDDEN);
+      check(engine->getBenchmarkCount() == 0, "a later start reads the winner back");
+    }
+  }
+  catch(const std::exception& e) {
+    SDL_Log("Unrecoverable error:  %s", e.what());
+    ++failures;
+  }
+
+  if(!cachePath.empty()) std::filesystem::remove(cachePath);
+
+  return(failures == 0 ? 0 : 1);
+}
@@ -0,0 +1,62 @@
+// File: bus_test.cpp
+// ----
+// A subscriber which republishes for the next frame on every delivery hears
+// once a frame, and the loop sleeps in between instead of spinning.
+
+#include <chrono>
+
+#include "jdi.hpp"
+
+struct tick_type {
+  int count;
+};
+
+int failures = 0;
+
+void check(bool isOK, const char* what) {
+  if(!isOK) {
+    SDL_Log("FAILED:  %s", what);
+    ++failures;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  jdi::EngineConfig config;
+  config.controller = jdi::JDI_SUBSYSTEM_OFF;
+  config.image = jdi::JDI_SUBSYSTEM_OFF;
+  config.ttf = jdi::JDI_SUBSYSTEM_OFF;
+  config.audio = jdi::JDI_SUBSYSTEM_OFF;
+  config.headless = true;  // No video needed
+
+  try {
+    jdi::engine_ptr engine = jdi::Engine::create(config);
+    engine->setFrameRate(1000/60);
+
+    jdi::EventBus& bus = engine->getEventBus();
+    int deliveries = 0;
+    bus.subscribe<tick_type>(nullptr, [&bus, &deliveries](const tick_type& tick) {
+        ++deliveries;
+        bus.publish(tick_type{tick.count + 1}, jdi::JDI_DELIVER_NEXT_FRAME);
+      });
+    bus.publish(tick_type{0}, jdi::JDI_DELIVER_NEXT_FRAME);
+
+    // Half a second is about 30 frames
+    int passes = 0;
+    auto start = std::chrono::steady_clock::now();
+    while(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500)) {
+      engine->step(100);
+      ++passes;
+    }
+
+    SDL_Log("%d deliveries in %d passes", deliveries, passes);
+    check(deliveries >= 10, "next-frame messages keep coming");
+    check(deliveries <= 40, "at most one delivery a frame");
+    check(passes <= 100, "the loop sleeps between frames");
+  }
+  catch(const std::exception& e) {
+    SDL_Log("Unrecoverable error:  %s", e.what());
+    ++failures;
+  }
+
+  return(failures == 0 ? 0 : 1);
+}
@@ -20,6 +20,7 @@ public:
   jdi::Color color;
   jdi::widget_ptr::weak_type linked_widget;  // Clicking me causes this linked widget to change visibility.
   Uint8 pct;  // From the left side, fill this percent of the block
+  bool isAnimated;  // Sweep pct once per update step
 
   jdi::font_ptr   font;
   jdi::sprite_ptr text;
@@ -32,13 +33,14 @@ public:
 
   virtual void onRenderUpdate(jdi::renderer_ptr renderer);
   virtual void onDraw(jdi::renderer_ptr renderer);
+  virtual void onUpdate(Uint32 ticks);
   virtual bool onEvent(jdi::renderer_ptr renderer,
                        SDL_Event* event);
 
   static blockwidget_ptr create();
 }; // end class BlockWidget
 
-BlockWidget::BlockWidget() : pct(100) {}
+BlockWidget::BlockWidget() : pct(100), isAnimated(false) {}
 BlockWidget::~BlockWidget() {}
 
 void BlockWidget::onRenderUpdate(jdi::renderer_ptr renderer) {
@@ -60,9 +62,11 @@ void BlockWidget::onDraw(jdi::renderer_ptr renderer) {
       SDL_RenderFillRect(renderer.get(),
                          drawRect);
     } else {
+      // Blend toward the next update step so the sweep stays smooth no matter
+      // how the frame and update rates line up.
+      float alpha = isAnimated ? getEngine()->getUpdateAlpha() : 0.0f;
       SDL_Rect paintRect = *drawRect;
-      paintRect.w *= pct;
-      paintRect.w /= 100;
+      paintRect.w = int(paintRect.w * (pct + alpha) / 100);
       SDL_RenderFillRect(renderer.get(),
                          &paintRect);
     }
@@ -83,12 +87,20 @@ void BlockWidget::onDraw(jdi::renderer_ptr renderer) {
   
 }
 
+void BlockWidget::onUpdate(Uint32 ticks) {
+  // Hold space to pause the animation
+  jdi::engine_ptr engine = getEngine();
+  if(isAnimated && !(engine && engine->getInputState().isKeyHeld(SDL_SCANCODE_SPACE))) {
+    pct = (pct + 1) % 101;
+  }
+}
+
 bool BlockWidget::onEvent(jdi::renderer_ptr renderer,
                           SDL_Event* event) {
   switch(event->type) {
   case SDL_KEYUP:    
     if(event->key.keysym.sym == SDLK_ESCAPE) {
-      jdi::engine_ptr engine = jdi::Engine::getEngine();
+      jdi::engine_ptr engine = getEngine();
       
       engine->removeWindow(engine->getWindow(getSelf()));
       return(true);
@@ -103,7 +115,7 @@ bool BlockWidget::onEvent(jdi::renderer_ptr renderer,
         jdi::widget_ptr widget = linked_widget.lock();
         
         if(widget) {
-          jdi::engine_ptr engine = jdi::Engine::getEngine();
+          jdi::engine_ptr engine = getEngine();
           
           widget->setVisible(!widget->isVisible());
           engine->requestResize(widget);
@@ -122,6 +134,9 @@ bool BlockWidget::onEvent(jdi::renderer_ptr renderer,
 blockwidget_ptr BlockWidget::create() {
   blockwidget_ptr reply(new BlockWidget());
   reply->setSelf(reply);
+  reply->setEventMask(jdi::JDI_EVENTS_KEY | jdi::JDI_EVENTS_MOUSE);
+  reply->setShortcutListener(true);  // ESC closes the window, focused or not
+  reply->setSimulating(true);
 
   return(reply);
 }
@@ -142,6 +157,7 @@ public:
   virtual ~ImageWidget() = default;
   virtual void onRenderUpdate(jdi::renderer_ptr renderer);
   virtual void onDraw(jdi::renderer_ptr renderer);
+  virtual void onRecord(jdi::DrawList& list);
 
   void sizeToImage();
 
@@ -153,7 +169,10 @@ void ImageWidget::onRenderUpdate(jdi::renderer_ptr renderer) {
     sprite = jdi::Sprite::createFromImage(fileName.c_str());
     sizeToImage();
   }
-  sprite->generateTexture(renderer);
+
+  // A pipelined engine makes the texture on the render thread when drawn
+  jdi::engine_ptr engine = getEngine();
+  if(sprite && !(engine && engine->isPipelined())) sprite->generateTexture(renderer);
 }
 
 void ImageWidget::onDraw(jdi::renderer_ptr renderer) {
@@ -163,6 +182,10 @@ void ImageWidget::onDraw(jdi::renderer_ptr renderer) {
   }
 }
 
+void ImageWidget::onRecord(jdi::DrawList& list) {
+  list.drawSprite(sprite, getDrawRect());
+}
+
 void ImageWidget::sizeToImage() {
   SDL_Rect spriteBBox;
   if(sprite && sprite->getSrcBBox(&spriteBBox)) {
@@ -174,6 +197,7 @@ void ImageWidget::sizeToImage() {
 imagewidget_ptr ImageWidget::create() {
   imagewidget_ptr reply(new ImageWidget());
   reply->setSelf(reply);
+  reply->setEventMask(jdi::JDI_EVENTS_NONE);
   
   return(reply);
 }
@@ -191,23 +215,6 @@ struct dwc_data_type {
 }; // end struct dwc_data_type
 
 
-Uint32 animateBlocks(Uint32 interval, void* data) {
-  blockwidget_seq_type *blocks = static_cast<blockwidget_seq_type*>(data);
-  //Uint64 jiffies = SDL_GetTicks64() / 10;
-  jdi::engine_ptr engine = jdi::Engine::getEngine();
-
-  for(auto& weakBlock : *blocks) {
-    blockwidget_ptr block = weakBlock.lock();
-
-    if(block == nullptr) return(0);  // A block disappeared!  We must exit quickly!
-    
-    block->pct = (block->pct + 1) % 101;
-    engine->requestUpdate(block);
-  }
-  return(interval);
-}
-  
-  
 extern "C" int main(int argc, char* argv[]) {
   dwc_data_type dwc_data[] = {
     {0, 0, 2, 1, jdi::Color::chocolate2(), 0, 1, jdi::JDI_NONE},
@@ -225,7 +232,15 @@ extern "C" int main(int argc, char* argv[]) {
   
   SDL_Log("Starting the engine...");
   
-  jdi::engine_ptr myEngine = jdi::Engine::getEngine();
+  // The font comes through loadFont() and nothing plays sound yet, so both
+  // can start on demand
+  jdi::EngineConfig config;
+  config.ttf = jdi::JDI_SUBSYSTEM_LAZY;
+  config.audio = jdi::JDI_SUBSYSTEM_LAZY;
+  jdi::engine_ptr myEngine = jdi::Engine::getEngine(config);
+
+  SDL_Log(" Video started in %lu usec",
+          (unsigned long)(jdi::Engine::getSubsystemInitUSec(jdi::JDI_SUBSYSTEM_VIDEO)));
 
   try {
     blockwidget_seq_type animatedBlocks;
@@ -306,9 +321,9 @@ extern "C" int main(int argc, char* argv[]) {
         blockTwo->color = dwc_data[idx].backColor;
         if(dwc_data[idx].backAnimate) {
           blockTwo->pct = 33;
+          blockTwo->isAnimated = true;
           animatedBlocks.push_back(blockTwo);
-          blockTwo->font = jdi::sdl_shared(TTF_OpenFontIndex("assets/FiraMono-Medium.ttf",
-                                                             24, 0));
+          blockTwo->font = myEngine->loadFont("assets/FiraMono-Medium.ttf", 24);
           blockTwo->text = jdi::sprite_ptr(new jdi::Sprite);                                           
         }        
         blockTwo->setAnchors(jdi::JDI_NSEW);
@@ -327,17 +342,19 @@ extern "C" int main(int argc, char* argv[]) {
         blockTwo->linked_widget = imageTwo;
       }
       
-      myEngine->setRoot(winTwo, gridTwo);      
+      myEngine->setRoot(winTwo, gridTwo);
+
+      // These change every update step, so keep their window drawing.
+      for(auto& weakBlock : animatedBlocks) {
+        myEngine->requestAnimation(weakBlock.lock());
+      }
     }    
     myEngine->setFrameRate(1000/60);  // 60fps
+    myEngine->setUpdateRate(1000/100);  // 100 updates/sec
     myEngine->requestResizeAll();
     myEngine->requestUpdateAll();
 
-    SDL_TimerID animateTimer = SDL_AddTimer(1000/100, animateBlocks, &animatedBlocks);  // 10 updates/sec
-    
     myEngine->mainLoop();
-
-    SDL_RemoveTimer(animateTimer);
   }
   catch(const jdi::Error& e) {
     if(e.where()[0]) {